@@ -0,0 +1,178 @@
+#include "Archive.h"
+#include "../vk/Image.h"
+#include "../vk/Shader.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace toffoo::asset {
+static const char archiveMagic[4] = {'T', 'P', 'A', 'K'};
+static const uint32_t archiveVersion = 1;
+
+// Level data offsets inside a texture payload, enough for any block size
+static const uint64_t levelAlignment = 16;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+Archive::Archive(const std::string &path) : file(path) {
+  ArchiveHeader header;
+  memcpy(&header, file.get(0, sizeof(header)).data(), sizeof(header));
+  if (memcmp(header.magic, archiveMagic, sizeof(archiveMagic)) != 0 ||
+      header.version != archiveVersion) {
+    throw std::runtime_error(path + " is not a supported archive!");
+  }
+
+  auto index = file.get(header.indexOffset,
+                        (size_t)header.entryCount * sizeof(ArchiveEntry));
+  auto first = reinterpret_cast<const ArchiveEntry *>(index.data());
+  for (uint32_t i = 0; i < header.entryCount; i++) {
+    const ArchiveEntry &entry = first[i];
+    // Validate once here so lookups can hand out the range unchecked
+    file.get(entry.offset, entry.size);
+    entries[std::string(entry.name, strnlen(entry.name, sizeof(entry.name)))] =
+        &entry;
+  }
+}
+
+bool Archive::contains(const std::string &name) {
+  return entries.contains(name);
+}
+
+std::span<const char> Archive::get(const std::string &name,
+                                   ArchiveEntryType type) {
+  auto it = entries.find(name);
+  if (it == entries.end() || it->second->type != type) {
+    throw std::runtime_error("archive has no entry " + name + "!");
+  }
+  return {file.data() + it->second->offset, it->second->size};
+}
+
+TextureData Archive::getTextureLayout(const std::string &name) {
+  auto payload = get(name, ArchiveEntryType::Texture);
+
+  ArchiveTextureHeader header;
+  if (payload.size() < sizeof(header)) {
+    throw std::runtime_error("texture " + name + " is truncated!");
+  }
+  memcpy(&header, payload.data(), sizeof(header));
+
+  TextureData texture{.format = header.format,
+                      .width = header.width,
+                      .height = header.height};
+  size_t levelsEnd =
+      sizeof(header) + (size_t)header.levelCount * sizeof(ArchiveLevel);
+  if (payload.size() < levelsEnd) {
+    throw std::runtime_error("texture " + name + " is truncated!");
+  }
+
+  for (uint32_t i = 0; i < header.levelCount; i++) {
+    ArchiveLevel level;
+    memcpy(&level, payload.data() + sizeof(header) + i * sizeof(level),
+           sizeof(level));
+    if (level.offset > payload.size() ||
+        level.size > payload.size() - level.offset) {
+      throw std::runtime_error("texture " + name + " is truncated!");
+    }
+    texture.levels.push_back({level.offset, level.size});
+  }
+  return texture;
+}
+
+std::shared_ptr<Archive> openArchive(const std::string &path) {
+  return std::make_shared<Archive>(path);
+}
+
+std::shared_ptr<vk::Shader> createShader(std::shared_ptr<vk::Device> device,
+                                         Archive &archive,
+                                         const std::string &name) {
+  return std::make_shared<vk::Shader>(
+      device, archive.get(name, ArchiveEntryType::Shader));
+}
+
+std::shared_ptr<vk::Image>
+createImage(std::shared_ptr<vk::Device> device,
+            std::shared_ptr<vk::CommandPool> command_pool, Archive &archive,
+            const std::string &name, const vk::SamplerDesc &samplerDesc) {
+  return createImage(device, command_pool, archive.getTextureLayout(name),
+                     archive.get(name, ArchiveEntryType::Texture),
+                     samplerDesc);
+}
+
+ArchiveWriter::ArchiveWriter(const std::string &path)
+    : file(path, std::ios::binary | std::ios::trunc) {
+  if (!file) {
+    throw std::runtime_error("failed to create " + path + "!");
+  }
+  // Patched by finish()
+  ArchiveHeader header{};
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+void ArchiveWriter::align() {
+  uint64_t position = file.tellp();
+  static const char zeros[archiveAlignment] = {};
+  file.write(zeros, alignUp(position, archiveAlignment) - position);
+}
+
+void ArchiveWriter::add(const std::string &name, ArchiveEntryType type,
+                        std::span<const char> data) {
+  ArchiveEntry entry{.type = type};
+  if (name.size() >= sizeof(entry.name)) {
+    throw std::invalid_argument("archive entry name " + name +
+                                " is too long!");
+  }
+  memcpy(entry.name, name.data(), name.size());
+
+  align();
+  entry.offset = file.tellp();
+  entry.size = data.size();
+  file.write(data.data(), data.size());
+  entries.push_back(entry);
+}
+
+void ArchiveWriter::addTexture(const std::string &name,
+                               const TextureData &texture) {
+  ArchiveTextureHeader header{.format = texture.format,
+                              .width = texture.width,
+                              .height = texture.height,
+                              .levelCount = (uint32_t)texture.levels.size()};
+
+  std::vector<ArchiveLevel> levels;
+  uint64_t offset = alignUp(
+      sizeof(header) + texture.levels.size() * sizeof(ArchiveLevel),
+      levelAlignment);
+  for (const auto &level : texture.levels) {
+    levels.push_back({.offset = offset, .size = level.size});
+    offset = alignUp(offset + level.size, levelAlignment);
+  }
+
+  std::vector<char> payload(offset);
+  memcpy(payload.data(), &header, sizeof(header));
+  memcpy(payload.data() + sizeof(header), levels.data(),
+         levels.size() * sizeof(ArchiveLevel));
+  for (size_t i = 0; i < levels.size(); i++) {
+    memcpy(payload.data() + levels[i].offset,
+           texture.data.data() + texture.levels[i].offset, levels[i].size);
+  }
+
+  add(name, ArchiveEntryType::Texture, payload);
+}
+
+void ArchiveWriter::finish() {
+  align();
+  ArchiveHeader header{.version = archiveVersion,
+                       .entryCount = (uint32_t)entries.size(),
+                       .indexOffset = (uint64_t)file.tellp()};
+  memcpy(header.magic, archiveMagic, sizeof(archiveMagic));
+
+  file.write(reinterpret_cast<const char *>(entries.data()),
+             entries.size() * sizeof(ArchiveEntry));
+  file.seekp(0);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.close();
+  if (!file) {
+    throw std::runtime_error("failed to write archive!");
+  }
+}
+} // namespace toffoo::asset
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../core/MappedFile.h"
+#include "../vk/SamplerCache.h"
+#include "TextureLoader.h"
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class CommandPool;
+class Image;
+class Shader;
+} // namespace toffoo::vk
+
+namespace toffoo::asset {
+// Payload offsets are multiples of this, which covers SPIR-V alignment and
+// optimalBufferCopyOffsetAlignment on every known device
+const uint64_t archiveAlignment = 256;
+
+enum class ArchiveEntryType : uint32_t { Blob, Shader, Texture };
+
+// On-disk layout: ArchiveHeader, the payloads, then entryCount ArchiveEntries
+// at indexOffset. Everything is little endian.
+struct ArchiveHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t reserved;
+  uint64_t indexOffset;
+};
+
+struct ArchiveEntry {
+  char name[64];
+  ArchiveEntryType type;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t size;
+};
+
+// Texture payloads start with this header followed by levelCount
+// ArchiveLevels, level offsets are relative to the payload
+struct ArchiveTextureHeader {
+  VkFormat format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t levelCount;
+};
+
+struct ArchiveLevel {
+  uint64_t offset;
+  uint64_t size;
+};
+
+// Packed, pre-cooked assets read through a memory mapping. Lookups hand out
+// views into the mapping, nothing is parsed or copied on the heap
+class Archive {
+private:
+  core::MappedFile file;
+  std::unordered_map<std::string, const ArchiveEntry *> entries;
+
+public:
+  Archive(const std::string &path);
+
+  bool contains(const std::string &name);
+
+  // Throws if the entry is missing or has another type
+  std::span<const char> get(const std::string &name, ArchiveEntryType type);
+
+  // Layout with an empty data vector, its levels index into the payload that
+  // get(name, ArchiveEntryType::Texture) returns
+  TextureData getTextureLayout(const std::string &name);
+};
+
+std::shared_ptr<Archive> openArchive(const std::string &path);
+
+std::shared_ptr<vk::Shader> createShader(std::shared_ptr<vk::Device> device,
+                                         Archive &archive,
+                                         const std::string &name);
+
+// The only copy is from the mapping into the staging buffer
+std::shared_ptr<vk::Image>
+createImage(std::shared_ptr<vk::Device> device,
+            std::shared_ptr<vk::CommandPool> command_pool, Archive &archive,
+            const std::string &name, const vk::SamplerDesc &samplerDesc = {});
+
+// Used by the cooker, payloads are streamed to disk as they are added
+class ArchiveWriter {
+private:
+  std::ofstream file;
+  std::vector<ArchiveEntry> entries;
+
+  void align();
+
+public:
+  ArchiveWriter(const std::string &path);
+
+  void add(const std::string &name, ArchiveEntryType type,
+           std::span<const char> data);
+
+  void addTexture(const std::string &name, const TextureData &texture);
+
+  // Writes the index, the archive is incomplete without it
+  void finish();
+};
+} // namespace toffoo::asset
@@ -0,0 +1,562 @@
+#include "Mesh.h"
+#include "../core/Json.h"
+#include "TextureLoader.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stdexcept>
+
+namespace toffoo::asset {
+static void setFaceNormal(MeshVertex &a, MeshVertex &b, MeshVertex &c) {
+  glm::vec3 p0 = glm::make_vec3(a.position);
+  glm::vec3 p1 = glm::make_vec3(b.position);
+  glm::vec3 p2 = glm::make_vec3(c.position);
+  glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+  float length = glm::length(normal);
+  if (length > 0.0f) {
+    normal /= length;
+  }
+  for (MeshVertex *vertex : {&a, &b, &c}) {
+    memcpy(vertex->normal, &normal, sizeof(vertex->normal));
+  }
+}
+
+static const char *skipSpaces(const char *s) {
+  while (*s == ' ' || *s == '\t') {
+    s++;
+  }
+  return s;
+}
+
+// OBJ indices are 1-based, negative ones count back from the last element
+static size_t resolveObjIndex(long index, size_t count) {
+  if (index > 0 && (size_t)index <= count) {
+    return index - 1;
+  }
+  if (index < 0 && (size_t)-index <= count) {
+    return count + index;
+  }
+  throw std::runtime_error("OBJ face references a missing element!");
+}
+
+MeshData loadObj(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error("failed to open " + path + "!");
+  }
+
+  std::vector<std::array<float, 3>> positions;
+  std::vector<std::array<float, 3>> normals;
+  std::vector<std::array<float, 2>> texCoords;
+
+  MeshData mesh;
+  std::vector<MeshVertex> face;
+  std::string line;
+  while (std::getline(file, line)) {
+    const char *s = skipSpaces(line.c_str());
+    char *end;
+
+    if (s[0] == 'v' && (s[1] == ' ' || s[1] == '\t')) {
+      std::array<float, 3> &p = positions.emplace_back();
+      s += 1;
+      for (float &value : p) {
+        value = std::strtof(s, &end);
+        s = end;
+      }
+    } else if (s[0] == 'v' && s[1] == 'n') {
+      std::array<float, 3> &n = normals.emplace_back();
+      s += 2;
+      for (float &value : n) {
+        value = std::strtof(s, &end);
+        s = end;
+      }
+    } else if (s[0] == 'v' && s[1] == 't') {
+      std::array<float, 2> &t = texCoords.emplace_back();
+      s += 2;
+      for (float &value : t) {
+        value = std::strtof(s, &end);
+        s = end;
+      }
+    } else if (s[0] == 'f' && (s[1] == ' ' || s[1] == '\t')) {
+      face.clear();
+      bool hasNormals = true;
+      s = skipSpaces(s + 1);
+      while (*s && *s != '\r' && *s != '#') {
+        MeshVertex vertex{};
+        auto p = positions[resolveObjIndex(std::strtol(s, &end, 10),
+                                           positions.size())];
+        memcpy(vertex.position, p.data(), sizeof(vertex.position));
+        s = end;
+
+        bool hasNormal = false;
+        if (*s == '/') {
+          s++;
+          if (*s != '/') {
+            auto t = texCoords[resolveObjIndex(std::strtol(s, &end, 10),
+                                               texCoords.size())];
+            vertex.texCoord[0] = t[0];
+            vertex.texCoord[1] = 1.0f - t[1];
+            s = end;
+          }
+          if (*s == '/') {
+            s++;
+            auto n = normals[resolveObjIndex(std::strtol(s, &end, 10),
+                                             normals.size())];
+            memcpy(vertex.normal, n.data(), sizeof(vertex.normal));
+            s = end;
+            hasNormal = true;
+          }
+        }
+        hasNormals = hasNormals && hasNormal;
+
+        face.push_back(vertex);
+        s = skipSpaces(s);
+      }
+
+      for (size_t i = 1; i + 1 < face.size(); i++) {
+        size_t base = mesh.vertices.size();
+        mesh.vertices.push_back(face[0]);
+        mesh.vertices.push_back(face[i]);
+        mesh.vertices.push_back(face[i + 1]);
+        if (!hasNormals) {
+          setFaceNormal(mesh.vertices[base], mesh.vertices[base + 1],
+                        mesh.vertices[base + 2]);
+        }
+        for (uint32_t j = 0; j < 3; j++) {
+          mesh.indices.push_back(base + j);
+        }
+      }
+    }
+  }
+  return mesh;
+}
+
+namespace {
+struct Gltf {
+  core::Json json;
+  std::vector<std::vector<char>> buffers;
+};
+} // namespace
+
+static const uint32_t glbMagic = 0x46546C67;
+static const uint32_t glbJsonChunk = 0x4E4F534A;
+static const uint32_t glbBinChunk = 0x004E4942;
+
+static const uint32_t gltfTriangles = 4;
+
+static std::vector<char> decodeBase64(std::string_view text) {
+  auto decode = [](char c) -> int {
+    if (c >= 'A' && c <= 'Z') {
+      return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+      return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+      return c - '0' + 52;
+    }
+    if (c == '+') {
+      return 62;
+    }
+    if (c == '/') {
+      return 63;
+    }
+    return -1;
+  };
+
+  std::vector<char> out;
+  out.reserve(text.size() / 4 * 3);
+  uint32_t bits = 0;
+  int bitCount = 0;
+  for (char c : text) {
+    int value = decode(c);
+    // Stops at the '=' padding
+    if (value < 0) {
+      break;
+    }
+    bits = (bits << 6) | value;
+    bitCount += 6;
+    if (bitCount >= 8) {
+      bitCount -= 8;
+      out.push_back((char)((bits >> bitCount) & 0xFF));
+    }
+  }
+  return out;
+}
+
+static std::vector<char> loadGltfBuffer(const core::Json &buffer,
+                                        std::vector<char> &glbBinary,
+                                        const std::filesystem::path &dir) {
+  if (!buffer.has("uri")) {
+    return std::move(glbBinary);
+  }
+
+  const std::string &uri = buffer["uri"].asString();
+  if (uri.starts_with("data:")) {
+    size_t comma = uri.find(',');
+    if (comma == std::string::npos ||
+        uri.substr(0, comma).find(";base64") == std::string::npos) {
+      throw std::runtime_error("unsupported glTF data URI!");
+    }
+    return decodeBase64(std::string_view(uri).substr(comma + 1));
+  }
+  return readFile((dir / uri).string());
+}
+
+static Gltf parseGltf(const std::string &path) {
+  auto file = readFile(path);
+  std::vector<char> glbBinary;
+  std::string_view jsonText(file.data(), file.size());
+
+  uint32_t magic = 0;
+  if (file.size() >= 4) {
+    memcpy(&magic, file.data(), sizeof(magic));
+  }
+  if (magic == glbMagic) {
+    // 12 byte header, then chunks of {length, type, data}
+    size_t offset = 12;
+    jsonText = {};
+    while (offset + 8 <= file.size()) {
+      uint32_t chunk[2];
+      memcpy(chunk, file.data() + offset, sizeof(chunk));
+      offset += 8;
+      if (chunk[0] > file.size() - offset) {
+        throw std::runtime_error("glb chunk is truncated!");
+      }
+      if (chunk[1] == glbJsonChunk) {
+        jsonText = {file.data() + offset, chunk[0]};
+      } else if (chunk[1] == glbBinChunk) {
+        glbBinary.assign(file.data() + offset,
+                         file.data() + offset + chunk[0]);
+      }
+      offset += chunk[0];
+    }
+  }
+
+  Gltf gltf{core::Json::parse(jsonText), {}};
+  auto dir = std::filesystem::path(path).parent_path();
+  if (gltf.json.has("buffers")) {
+    const auto &buffers = gltf.json["buffers"];
+    for (size_t i = 0; i < buffers.size(); i++) {
+      gltf.buffers.push_back(loadGltfBuffer(buffers[i], glbBinary, dir));
+    }
+  }
+  return gltf;
+}
+
+static size_t getComponentCount(const std::string &type) {
+  if (type == "SCALAR") {
+    return 1;
+  }
+  if (type == "VEC2") {
+    return 2;
+  }
+  if (type == "VEC3") {
+    return 3;
+  }
+  if (type == "VEC4") {
+    return 4;
+  }
+  throw std::runtime_error("unsupported glTF accessor type " + type + "!");
+}
+
+static size_t getComponentSize(uint32_t componentType) {
+  switch (componentType) {
+  case 5120: // BYTE
+  case 5121: // UNSIGNED_BYTE
+    return 1;
+  case 5122: // SHORT
+  case 5123: // UNSIGNED_SHORT
+    return 2;
+  case 5125: // UNSIGNED_INT
+  case 5126: // FLOAT
+    return 4;
+  default:
+    throw std::runtime_error("unsupported glTF component type!");
+  }
+}
+
+// Reads an accessor as floats, integer components are converted as
+// normalized values the way the spec defines them for vertex attributes
+static std::vector<float> readAccessor(const Gltf &gltf, size_t index,
+                                       size_t components) {
+  const auto &accessor = gltf.json["accessors"][index];
+  if (accessor.has("sparse")) {
+    throw std::runtime_error("sparse glTF accessors are not supported!");
+  }
+
+  size_t count = accessor["count"].asNumber();
+  if (getComponentCount(accessor["type"].asString()) != components) {
+    throw std::runtime_error("glTF accessor has the wrong type!");
+  }
+  std::vector<float> values(count * components);
+  if (!accessor.has("bufferView")) {
+    return values;
+  }
+
+  uint32_t componentType = accessor["componentType"].asNumber();
+  size_t componentSize = getComponentSize(componentType);
+  size_t elementSize = componentSize * components;
+
+  const auto &view =
+      gltf.json["bufferViews"][(size_t)accessor["bufferView"].asNumber()];
+  const auto &buffer = gltf.buffers.at((size_t)view["buffer"].asNumber());
+  size_t offset = view.get("byteOffset", 0) + accessor.get("byteOffset", 0);
+  size_t stride = view.get("byteStride", elementSize);
+  if (count > 0 &&
+      offset + stride * (count - 1) + elementSize > buffer.size()) {
+    throw std::runtime_error("glTF accessor is out of bounds!");
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    const char *element = buffer.data() + offset + i * stride;
+    for (size_t c = 0; c < components; c++) {
+      const char *src = element + c * componentSize;
+      float &dst = values[i * components + c];
+      switch (componentType) {
+      case 5126:
+        memcpy(&dst, src, sizeof(float));
+        break;
+      case 5121:
+        dst = *(const uint8_t *)src / 255.0f;
+        break;
+      case 5123: {
+        uint16_t value;
+        memcpy(&value, src, sizeof(value));
+        dst = value / 65535.0f;
+        break;
+      }
+      case 5120:
+        dst = std::max(*(const int8_t *)src / 127.0f, -1.0f);
+        break;
+      case 5122: {
+        int16_t value;
+        memcpy(&value, src, sizeof(value));
+        dst = std::max(value / 32767.0f, -1.0f);
+        break;
+      }
+      default:
+        throw std::runtime_error("unsupported glTF attribute component type!");
+      }
+    }
+  }
+  return values;
+}
+
+static std::vector<uint32_t> readIndices(const Gltf &gltf, size_t index) {
+  const auto &accessor = gltf.json["accessors"][index];
+  size_t count = accessor["count"].asNumber();
+  uint32_t componentType = accessor["componentType"].asNumber();
+  size_t componentSize = getComponentSize(componentType);
+
+  const auto &view =
+      gltf.json["bufferViews"][(size_t)accessor["bufferView"].asNumber()];
+  const auto &buffer = gltf.buffers.at((size_t)view["buffer"].asNumber());
+  size_t offset = view.get("byteOffset", 0) + accessor.get("byteOffset", 0);
+  if (offset + count * componentSize > buffer.size()) {
+    throw std::runtime_error("glTF accessor is out of bounds!");
+  }
+
+  std::vector<uint32_t> indices(count);
+  for (size_t i = 0; i < count; i++) {
+    const char *src = buffer.data() + offset + i * componentSize;
+    if (componentType == 5121) {
+      indices[i] = *(const uint8_t *)src;
+    } else if (componentType == 5123) {
+      uint16_t value;
+      memcpy(&value, src, sizeof(value));
+      indices[i] = value;
+    } else if (componentType == 5125) {
+      memcpy(&indices[i], src, sizeof(uint32_t));
+    } else {
+      throw std::runtime_error("unsupported glTF index component type!");
+    }
+  }
+  return indices;
+}
+
+static void addPrimitive(const Gltf &gltf, const core::Json &primitive,
+                         const glm::mat4 &transform, MeshData &mesh) {
+  if (primitive.get("mode", gltfTriangles) != gltfTriangles) {
+    return;
+  }
+
+  const auto &attributes = primitive["attributes"];
+  auto positions = readAccessor(gltf, attributes["POSITION"].asNumber(), 3);
+  size_t vertexCount = positions.size() / 3;
+
+  bool hasNormals = attributes.has("NORMAL");
+  std::vector<float> normals =
+      hasNormals ? readAccessor(gltf, attributes["NORMAL"].asNumber(), 3)
+                 : std::vector<float>(vertexCount * 3);
+  std::vector<float> texCoords =
+      attributes.has("TEXCOORD_0")
+          ? readAccessor(gltf, attributes["TEXCOORD_0"].asNumber(), 2)
+          : std::vector<float>(vertexCount * 2);
+  if (normals.size() != vertexCount * 3 ||
+      texCoords.size() != vertexCount * 2) {
+    throw std::runtime_error("glTF attribute count does not match the "
+                             "positions!");
+  }
+
+  std::vector<uint32_t> indices;
+  if (primitive.has("indices")) {
+    indices = readIndices(gltf, primitive["indices"].asNumber());
+  } else {
+    for (uint32_t i = 0; i < vertexCount; i++) {
+      indices.push_back(i);
+    }
+  }
+
+  glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+  // Mirroring transforms flip the winding
+  bool flip = glm::determinant(glm::mat3(transform)) < 0.0f;
+
+  std::vector<MeshVertex> vertices(vertexCount);
+  for (size_t i = 0; i < vertexCount; i++) {
+    glm::vec3 position =
+        transform * glm::vec4(glm::make_vec3(&positions[i * 3]), 1.0f);
+    glm::vec3 normal = normalMatrix * glm::make_vec3(&normals[i * 3]);
+    if (glm::length(normal) > 0.0f) {
+      normal = glm::normalize(normal);
+    }
+    memcpy(vertices[i].position, &position, sizeof(vertices[i].position));
+    memcpy(vertices[i].normal, &normal, sizeof(vertices[i].normal));
+    memcpy(vertices[i].texCoord, &texCoords[i * 2],
+           sizeof(vertices[i].texCoord));
+  }
+
+  uint32_t base = mesh.vertices.size();
+  if (hasNormals) {
+    mesh.vertices.insert(mesh.vertices.end(), vertices.begin(),
+                         vertices.end());
+  }
+
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    uint32_t triangle[3] = {indices[i], indices[i + 1], indices[i + 2]};
+    if (flip) {
+      std::swap(triangle[1], triangle[2]);
+    }
+    for (uint32_t index : triangle) {
+      if (index >= vertexCount) {
+        throw std::runtime_error("glTF index is out of range!");
+      }
+    }
+
+    if (hasNormals) {
+      for (uint32_t index : triangle) {
+        mesh.indices.push_back(base + index);
+      }
+      continue;
+    }
+
+    // Without normals the spec asks for flat shading, so every corner gets
+    // its own vertex
+    size_t first = mesh.vertices.size();
+    for (uint32_t index : triangle) {
+      mesh.indices.push_back(mesh.vertices.size());
+      mesh.vertices.push_back(vertices[index]);
+    }
+    setFaceNormal(mesh.vertices[first], mesh.vertices[first + 1],
+                  mesh.vertices[first + 2]);
+  }
+}
+
+static glm::mat4 getLocalTransform(const core::Json &node) {
+  if (node.has("matrix")) {
+    float matrix[16];
+    for (size_t i = 0; i < 16; i++) {
+      matrix[i] = node["matrix"][i].asNumber();
+    }
+    return glm::make_mat4(matrix);
+  }
+
+  glm::mat4 transform(1.0f);
+  if (node.has("translation")) {
+    const auto &t = node["translation"];
+    transform = glm::translate(
+        transform, glm::vec3(t[0].asNumber(), t[1].asNumber(),
+                             t[2].asNumber()));
+  }
+  if (node.has("rotation")) {
+    const auto &r = node["rotation"];
+    transform *= glm::mat4_cast(glm::quat(r[3].asNumber(), r[0].asNumber(),
+                                          r[1].asNumber(), r[2].asNumber()));
+  }
+  if (node.has("scale")) {
+    const auto &s = node["scale"];
+    transform = glm::scale(transform, glm::vec3(s[0].asNumber(),
+                                                s[1].asNumber(),
+                                                s[2].asNumber()));
+  }
+  return transform;
+}
+
+static void addMesh(const Gltf &gltf, size_t index,
+                    const glm::mat4 &transform, MeshData &mesh) {
+  const auto &primitives = gltf.json["meshes"][index]["primitives"];
+  for (size_t i = 0; i < primitives.size(); i++) {
+    addPrimitive(gltf, primitives[i], transform, mesh);
+  }
+}
+
+static void addNode(const Gltf &gltf, size_t index, const glm::mat4 &parent,
+                    MeshData &mesh, size_t depth) {
+  if (depth > gltf.json["nodes"].size()) {
+    throw std::runtime_error("glTF node hierarchy has a cycle!");
+  }
+
+  const auto &node = gltf.json["nodes"][index];
+  glm::mat4 transform = parent * getLocalTransform(node);
+  if (node.has("mesh")) {
+    addMesh(gltf, node["mesh"].asNumber(), transform, mesh);
+  }
+  if (node.has("children")) {
+    const auto &children = node["children"];
+    for (size_t i = 0; i < children.size(); i++) {
+      addNode(gltf, children[i].asNumber(), transform, mesh, depth + 1);
+    }
+  }
+}
+
+MeshData loadGltf(const std::string &path) {
+  Gltf gltf = parseGltf(path);
+  MeshData mesh;
+
+  // Files without scenes are libraries of meshes, take them untransformed
+  if (!gltf.json.has("scenes") || gltf.json["scenes"].size() == 0) {
+    if (gltf.json.has("meshes")) {
+      for (size_t i = 0; i < gltf.json["meshes"].size(); i++) {
+        addMesh(gltf, i, glm::mat4(1.0f), mesh);
+      }
+    }
+    return mesh;
+  }
+
+  const auto &scene = gltf.json["scenes"][(size_t)gltf.json.get("scene", 0)];
+  if (scene.has("nodes")) {
+    for (size_t i = 0; i < scene["nodes"].size(); i++) {
+      addNode(gltf, scene["nodes"][i].asNumber(), glm::mat4(1.0f), mesh, 0);
+    }
+  }
+  return mesh;
+}
+
+MeshData loadMesh(const std::string &path) {
+  auto extension = std::filesystem::path(path).extension().string();
+  if (extension == ".obj") {
+    return loadObj(path);
+  }
+  if (extension == ".gltf" || extension == ".glb") {
+    return loadGltf(path);
+  }
+  throw std::runtime_error("unknown mesh format " + path + "!");
+}
+} // namespace toffoo::asset
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace toffoo::asset {
+struct MeshVertex {
+  float position[3];
+  float normal[3];
+  float texCoord[2];
+};
+
+// Indexed triangle list, texture coordinates have their origin at the top left
+struct MeshData {
+  std::vector<MeshVertex> vertices;
+  std::vector<uint32_t> indices;
+};
+
+// Polygons are fanned into triangles, materials and groups are ignored
+MeshData loadObj(const std::string &path);
+
+// .gltf with external or data URI buffers and .glb. Triangle primitives of the
+// default scene are merged with their node transforms applied.
+MeshData loadGltf(const std::string &path);
+
+// Picks the importer by extension
+MeshData loadMesh(const std::string &path);
+} // namespace toffoo::asset
@@ -0,0 +1,345 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
+
+namespace toffoo::asset {
+void deduplicateVertices(MeshData &mesh) {
+  std::unordered_map<std::string_view, uint32_t> unique;
+  std::vector<MeshVertex> vertices;
+  std::vector<uint32_t> remap(mesh.vertices.size());
+
+  for (size_t i = 0; i < mesh.vertices.size(); i++) {
+    std::string_view key(reinterpret_cast<const char *>(&mesh.vertices[i]),
+                         sizeof(MeshVertex));
+    auto [it, inserted] = unique.try_emplace(key, (uint32_t)vertices.size());
+    if (inserted) {
+      vertices.push_back(mesh.vertices[i]);
+    }
+    remap[i] = it->second;
+  }
+
+  std::vector<uint32_t> indices;
+  indices.reserve(mesh.indices.size());
+  for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+    uint32_t a = remap[mesh.indices[i]];
+    uint32_t b = remap[mesh.indices[i + 1]];
+    uint32_t c = remap[mesh.indices[i + 2]];
+    if (a != b && b != c && c != a) {
+      indices.insert(indices.end(), {a, b, c});
+    }
+  }
+
+  // The keys point into the old vertices
+  unique.clear();
+  mesh.vertices = std::move(vertices);
+  mesh.indices = std::move(indices);
+}
+
+namespace {
+// Triangles using each vertex, in CSR layout
+struct Adjacency {
+  std::vector<uint32_t> offsets;
+  std::vector<uint32_t> triangles;
+
+  Adjacency(const std::vector<uint32_t> &indices, size_t vertexCount)
+      : offsets(vertexCount + 1), triangles(indices.size()) {
+    for (uint32_t index : indices) {
+      offsets[index + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) {
+      triangles[fill[indices[i]]++] = i / 3;
+    }
+  }
+
+  uint32_t count(uint32_t vertex) const {
+    return offsets[vertex + 1] - offsets[vertex];
+  }
+};
+
+class TipsifyWalk {
+private:
+  const std::vector<uint32_t> &indices;
+  uint32_t cacheSize;
+  Adjacency adjacency;
+  std::vector<uint32_t> live;
+  std::vector<uint32_t> timestamps;
+  std::vector<bool> emitted;
+  std::vector<uint32_t> deadEnds;
+  uint32_t time;
+  uint32_t cursor = 0;
+
+  // Prefers the candidate that will still be in the cache once all of its
+  // triangles are emitted, the oldest one of those
+  int64_t getNextVertex(const std::vector<uint32_t> &candidates) {
+    int64_t next = -1;
+    int64_t best = -1;
+    for (uint32_t vertex : candidates) {
+      if (live[vertex] == 0) {
+        continue;
+      }
+      int64_t priority = 0;
+      if (time - timestamps[vertex] + 2 * live[vertex] <= cacheSize) {
+        priority = time - timestamps[vertex];
+      }
+      if (priority > best) {
+        best = priority;
+        next = vertex;
+      }
+    }
+    return next;
+  }
+
+  int64_t skipDeadEnd() {
+    while (!deadEnds.empty()) {
+      uint32_t vertex = deadEnds.back();
+      deadEnds.pop_back();
+      if (live[vertex] > 0) {
+        return vertex;
+      }
+    }
+    for (; cursor < live.size(); cursor++) {
+      if (live[cursor] > 0) {
+        return cursor;
+      }
+    }
+    return -1;
+  }
+
+public:
+  TipsifyWalk(const std::vector<uint32_t> &indices, size_t vertexCount,
+              uint32_t cacheSize)
+      : indices(indices), cacheSize(cacheSize),
+        adjacency(indices, vertexCount), live(vertexCount),
+        timestamps(vertexCount, 0), emitted(indices.size() / 3),
+        time(cacheSize + 1) {
+    for (size_t i = 0; i < vertexCount; i++) {
+      live[i] = adjacency.count(i);
+    }
+  }
+
+  void run(std::vector<uint32_t> &output, std::vector<uint32_t> &clusters) {
+    std::vector<uint32_t> candidates;
+    int64_t vertex = skipDeadEnd();
+    clusters.push_back(0);
+
+    while (vertex >= 0) {
+      candidates.clear();
+      for (uint32_t i = adjacency.offsets[vertex];
+           i < adjacency.offsets[vertex + 1]; i++) {
+        uint32_t triangle = adjacency.triangles[i];
+        if (emitted[triangle]) {
+          continue;
+        }
+        emitted[triangle] = true;
+
+        for (uint32_t k = 0; k < 3; k++) {
+          uint32_t corner = indices[triangle * 3 + k];
+          output.push_back(corner);
+          deadEnds.push_back(corner);
+          candidates.push_back(corner);
+          live[corner]--;
+          if (time - timestamps[corner] > cacheSize) {
+            timestamps[corner] = time++;
+          }
+        }
+      }
+
+      vertex = getNextVertex(candidates);
+      if (vertex < 0) {
+        vertex = skipDeadEnd();
+        if (vertex >= 0) {
+          clusters.push_back(output.size() / 3);
+        }
+      }
+    }
+  }
+};
+} // namespace
+
+std::vector<uint32_t> optimizeVertexCache(std::vector<uint32_t> &indices,
+                                          size_t vertexCount,
+                                          uint32_t cacheSize) {
+  std::vector<uint32_t> output;
+  std::vector<uint32_t> clusters;
+  output.reserve(indices.size());
+
+  TipsifyWalk(indices, vertexCount, cacheSize).run(output, clusters);
+
+  indices = std::move(output);
+  return clusters;
+}
+
+// Splits where the cluster so far already reached the target miss ratio, so
+// sorting the pieces costs little cache efficiency
+static std::vector<uint32_t>
+splitClusters(const std::vector<uint32_t> &indices, size_t vertexCount,
+              const std::vector<uint32_t> &clusters, uint32_t cacheSize,
+              float threshold) {
+  float target = getAcmr(indices, vertexCount, cacheSize) * threshold;
+  size_t triangleCount = indices.size() / 3;
+
+  std::vector<uint32_t> timestamps(vertexCount, 0);
+  uint32_t time = cacheSize + 1;
+  std::vector<uint32_t> split;
+
+  for (size_t c = 0; c < clusters.size(); c++) {
+    size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+    // Starting a cluster flushes the cache, as it may be drawn anywhere
+    time += cacheSize + 1;
+    uint32_t start = clusters[c];
+    uint32_t misses = 0;
+    split.push_back(start);
+
+    for (size_t t = start; t < end; t++) {
+      for (uint32_t k = 0; k < 3; k++) {
+        uint32_t vertex = indices[t * 3 + k];
+        if (time - timestamps[vertex] > cacheSize) {
+          timestamps[vertex] = time++;
+          misses++;
+        }
+      }
+      if (t + 1 < end && misses <= target * (t + 1 - start)) {
+        time += cacheSize + 1;
+        start = t + 1;
+        misses = 0;
+        split.push_back(start);
+      }
+    }
+  }
+  return split;
+}
+
+void optimizeOverdraw(std::vector<uint32_t> &indices,
+                      const std::vector<MeshVertex> &vertices,
+                      const std::vector<uint32_t> &clusters,
+                      uint32_t cacheSize, float threshold) {
+  if (indices.empty()) {
+    return;
+  }
+  auto split =
+      splitClusters(indices, vertices.size(), clusters, cacheSize, threshold);
+  size_t triangleCount = indices.size() / 3;
+
+  // Area weighted, so the mesh center does not drift to dense regions
+  struct Cluster {
+    float centroid[3] = {};
+    float normal[3] = {};
+    float area = 0.0f;
+    float sortKey = 0.0f;
+  };
+  std::vector<Cluster> infos(split.size());
+  float meshCentroid[3] = {};
+  float meshArea = 0.0f;
+
+  for (size_t c = 0; c < split.size(); c++) {
+    size_t end = c + 1 < split.size() ? split[c + 1] : triangleCount;
+    Cluster &info = infos[c];
+    for (size_t t = split[c]; t < end; t++) {
+      const float *p0 = vertices[indices[t * 3]].position;
+      const float *p1 = vertices[indices[t * 3 + 1]].position;
+      const float *p2 = vertices[indices[t * 3 + 2]].position;
+
+      float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+      float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+      float n[3] = {e1[1] * e2[2] - e1[2] * e2[1],
+                    e1[2] * e2[0] - e1[0] * e2[2],
+                    e1[0] * e2[1] - e1[1] * e2[0]};
+      float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+      for (int k = 0; k < 3; k++) {
+        info.centroid[k] += (p0[k] + p1[k] + p2[k]) / 3.0f * area;
+        info.normal[k] += n[k];
+      }
+      info.area += area;
+    }
+
+    for (int k = 0; k < 3; k++) {
+      meshCentroid[k] += info.centroid[k];
+      if (info.area > 0.0f) {
+        info.centroid[k] /= info.area;
+      }
+    }
+    meshArea += info.area;
+  }
+
+  for (int k = 0; k < 3; k++) {
+    meshCentroid[k] = meshArea > 0.0f ? meshCentroid[k] / meshArea : 0.0f;
+  }
+
+  for (Cluster &info : infos) {
+    float length = std::sqrt(info.normal[0] * info.normal[0] +
+                             info.normal[1] * info.normal[1] +
+                             info.normal[2] * info.normal[2]);
+    if (length == 0.0f) {
+      continue;
+    }
+    for (int k = 0; k < 3; k++) {
+      info.sortKey += (info.centroid[k] - meshCentroid[k]) * info.normal[k];
+    }
+    info.sortKey /= length;
+  }
+
+  std::vector<uint32_t> order(split.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return infos[a].sortKey > infos[b].sortKey;
+  });
+
+  std::vector<uint32_t> output;
+  output.reserve(indices.size());
+  for (uint32_t c : order) {
+    size_t end = c + 1 < split.size() ? split[c + 1] : triangleCount;
+    output.insert(output.end(), indices.begin() + split[c] * 3,
+                  indices.begin() + end * 3);
+  }
+  indices = std::move(output);
+}
+
+void optimizeVertexFetch(MeshData &mesh) {
+  const uint32_t unused = UINT32_MAX;
+  std::vector<uint32_t> remap(mesh.vertices.size(), unused);
+  std::vector<MeshVertex> vertices;
+  vertices.reserve(mesh.vertices.size());
+
+  for (uint32_t &index : mesh.indices) {
+    if (remap[index] == unused) {
+      remap[index] = vertices.size();
+      vertices.push_back(mesh.vertices[index]);
+    }
+    index = remap[index];
+  }
+  mesh.vertices = std::move(vertices);
+}
+
+float getAcmr(const std::vector<uint32_t> &indices, size_t vertexCount,
+              uint32_t cacheSize) {
+  if (indices.size() < 3) {
+    return 0.0f;
+  }
+
+  std::vector<uint32_t> timestamps(vertexCount, 0);
+  uint32_t time = cacheSize + 1;
+  size_t misses = 0;
+  for (uint32_t index : indices) {
+    if (time - timestamps[index] > cacheSize) {
+      timestamps[index] = time++;
+      misses++;
+    }
+  }
+  return (float)misses / (indices.size() / 3);
+}
+
+void optimizeMesh(MeshData &mesh) {
+  deduplicateVertices(mesh);
+  auto clusters = optimizeVertexCache(mesh.indices, mesh.vertices.size());
+  optimizeOverdraw(mesh.indices, mesh.vertices, clusters);
+  optimizeVertexFetch(mesh);
+}
+} // namespace toffoo::asset
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Mesh.h"
+#include <cstdint>
+#include <vector>
+
+namespace toffoo::asset {
+// Merges bitwise identical vertices and drops triangles that collapse
+void deduplicateVertices(MeshData &mesh);
+
+// Reorders triangles for a post-transform vertex cache of cacheSize entries
+// (Tipsify). Returns the first triangle of every cluster, clusters end where
+// the walk ran into a dead end.
+std::vector<uint32_t> optimizeVertexCache(std::vector<uint32_t> &indices,
+                                          size_t vertexCount,
+                                          uint32_t cacheSize = 16);
+
+// Sorts the clusters so the ones facing away from the mesh center are drawn
+// first, which tends to occlude the rest. Clusters are split further while the
+// cache efficiency stays within threshold of the whole mesh.
+void optimizeOverdraw(std::vector<uint32_t> &indices,
+                      const std::vector<MeshVertex> &vertices,
+                      const std::vector<uint32_t> &clusters,
+                      uint32_t cacheSize = 16, float threshold = 1.05f);
+
+// Orders vertices by first use in the index buffer, unused ones are dropped
+void optimizeVertexFetch(MeshData &mesh);
+
+// Average cache miss ratio, transformed vertices per triangle for a FIFO cache
+float getAcmr(const std::vector<uint32_t> &indices, size_t vertexCount,
+              uint32_t cacheSize = 16);
+
+// All of the above in the order they depend on each other
+void optimizeMesh(MeshData &mesh);
+} // namespace toffoo::asset
@@ -0,0 +1,303 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+
+namespace toffoo::asset {
+namespace {
+// Sum of squared distances to planes, weighted by triangle area. Divided by
+// the total weight this is the mean squared distance.
+struct Quadric {
+  float a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+  float b0 = 0, b1 = 0, b2 = 0, c = 0;
+  float weight = 0;
+
+  static Quadric fromPlane(const float n[3], float d, float weight) {
+    Quadric q;
+    q.a00 = n[0] * n[0] * weight;
+    q.a01 = n[0] * n[1] * weight;
+    q.a02 = n[0] * n[2] * weight;
+    q.a11 = n[1] * n[1] * weight;
+    q.a12 = n[1] * n[2] * weight;
+    q.a22 = n[2] * n[2] * weight;
+    q.b0 = n[0] * d * weight;
+    q.b1 = n[1] * d * weight;
+    q.b2 = n[2] * d * weight;
+    q.c = d * d * weight;
+    q.weight = weight;
+    return q;
+  }
+
+  Quadric &operator+=(const Quadric &o) {
+    a00 += o.a00, a01 += o.a01, a02 += o.a02;
+    a11 += o.a11, a12 += o.a12, a22 += o.a22;
+    b0 += o.b0, b1 += o.b1, b2 += o.b2;
+    c += o.c;
+    weight += o.weight;
+    return *this;
+  }
+
+  float getError(const float p[3]) const {
+    float e = a00 * p[0] * p[0] + a11 * p[1] * p[1] + a22 * p[2] * p[2] +
+              2 * (a01 * p[0] * p[1] + a02 * p[0] * p[2] + a12 * p[1] * p[2]) +
+              2 * (b0 * p[0] + b1 * p[1] + b2 * p[2]) + c;
+    return weight > 0.0f ? std::max(e, 0.0f) / weight : 0.0f;
+  }
+};
+
+struct Collapse {
+  uint32_t from;
+  uint32_t to;
+  // Vertex of to in the triangles of the edge, takes over the corners of from
+  uint32_t toVertex;
+  float error;
+};
+
+} // namespace
+
+// Unnormalized, its length is twice the triangle area
+static void getNormal(const float *p0, const float *p1, const float *p2,
+                      float n[3]) {
+  float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+  float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+  n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+  n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+  n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+static uint64_t getEdgeKey(uint32_t a, uint32_t b) {
+  return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+}
+
+std::vector<uint32_t> simplifyMesh(const std::vector<uint32_t> &indices,
+                                   const std::vector<MeshVertex> &vertices,
+                                   size_t targetIndexCount, float maxError,
+                                   float *resultError) {
+  // Vertices split by normals or texture coordinates share a position, the
+  // topology is built on positions
+  std::unordered_map<std::string_view, uint32_t> uniquePositions;
+  std::vector<uint32_t> positionOf(vertices.size());
+  std::vector<uint32_t> wedgeCount;
+  std::vector<const float *> positions;
+  for (size_t i = 0; i < vertices.size(); i++) {
+    std::string_view key(
+        reinterpret_cast<const char *>(vertices[i].position),
+        sizeof(vertices[i].position));
+    auto [it, inserted] =
+        uniquePositions.try_emplace(key, (uint32_t)positions.size());
+    if (inserted) {
+      positions.push_back(vertices[i].position);
+      wedgeCount.push_back(0);
+    }
+    positionOf[i] = it->second;
+    wedgeCount[it->second]++;
+  }
+
+  // Edges used by one triangle are borders, by more than two non-manifold
+  std::unordered_map<uint64_t, uint32_t> edgeUse;
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    for (int k = 0; k < 3; k++) {
+      edgeUse[getEdgeKey(positionOf[indices[i + k]],
+                         positionOf[indices[i + (k + 1) % 3]])]++;
+    }
+  }
+  std::vector<bool> locked(positions.size());
+  for (size_t p = 0; p < positions.size(); p++) {
+    locked[p] = wedgeCount[p] > 1;
+  }
+  for (const auto &[key, count] : edgeUse) {
+    if (count != 2) {
+      locked[key >> 32] = true;
+      locked[key & 0xffffffff] = true;
+    }
+  }
+
+  std::vector<Quadric> quadrics(positions.size());
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    const float *p0 = positions[positionOf[indices[i]]];
+    float n[3];
+    getNormal(p0, positions[positionOf[indices[i + 1]]],
+              positions[positionOf[indices[i + 2]]], n);
+    float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length == 0.0f) {
+      continue;
+    }
+    for (float &value : n) {
+      value /= length;
+    }
+    Quadric q = Quadric::fromPlane(
+        n, -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]), length * 0.5f);
+    for (int k = 0; k < 3; k++) {
+      quadrics[positionOf[indices[i + k]]] += q;
+    }
+  }
+
+  std::vector<uint32_t> result = indices;
+  // Overflows to infinity for the default, which disables the limit
+  float maxErrorSquared = maxError * maxError;
+  float reachedError = 0.0f;
+
+  // Every pass applies the cheapest collapses whose neighborhoods do not
+  // overlap, so the flip test of one is not invalidated by another
+  while (result.size() > targetIndexCount) {
+    std::vector<Collapse> collapses;
+    for (size_t i = 0; i + 2 < result.size(); i += 3) {
+      for (int k = 0; k < 3; k++) {
+        uint32_t va = result[i + k];
+        uint32_t vb = result[i + (k + 1) % 3];
+        uint32_t a = positionOf[va];
+        uint32_t b = positionOf[vb];
+        for (auto [from, to, toVertex] :
+             {std::tuple{a, b, vb}, std::tuple{b, a, va}}) {
+          if (locked[from]) {
+            continue;
+          }
+          Quadric q = quadrics[from];
+          q += quadrics[to];
+          collapses.push_back({from, to, toVertex, q.getError(positions[to])});
+        }
+      }
+    }
+    std::sort(collapses.begin(), collapses.end(),
+              [](const Collapse &a, const Collapse &b) {
+                return a.error < b.error;
+              });
+
+    // Triangles around each position, for the flip test
+    std::vector<uint32_t> offsets(positions.size() + 1);
+    for (uint32_t index : result) {
+      offsets[positionOf[index] + 1]++;
+    }
+    for (size_t p = 0; p < positions.size(); p++) {
+      offsets[p + 1] += offsets[p];
+    }
+    std::vector<uint32_t> triangles(result.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < result.size(); i++) {
+      triangles[fill[positionOf[result[i]]]++] = i / 3;
+    }
+
+    std::vector<uint32_t> remap(vertices.size());
+    for (size_t i = 0; i < remap.size(); i++) {
+      remap[i] = i;
+    }
+    std::vector<bool> touched(positions.size());
+    // An interior collapse removes the two triangles of its edge
+    size_t budget = (result.size() - targetIndexCount + 5) / 6;
+    size_t applied = 0;
+
+    for (const Collapse &collapse : collapses) {
+      if (applied >= budget || collapse.error > maxErrorSquared) {
+        break;
+      }
+      if (touched[collapse.from] || touched[collapse.to]) {
+        continue;
+      }
+
+      bool flips = false;
+      for (uint32_t i = offsets[collapse.from];
+           i < offsets[collapse.from + 1] && !flips; i++) {
+        const uint32_t *corners = &result[triangles[i] * 3];
+        const float *before[3];
+        const float *after[3];
+        bool hasTo = false;
+        for (int k = 0; k < 3; k++) {
+          uint32_t p = positionOf[corners[k]];
+          hasTo = hasTo || p == collapse.to;
+          before[k] = positions[p];
+          after[k] = p == collapse.from ? positions[collapse.to] : before[k];
+        }
+        if (hasTo) {
+          continue;
+        }
+        float n0[3], n1[3];
+        getNormal(before[0], before[1], before[2], n0);
+        getNormal(after[0], after[1], after[2], n1);
+        flips = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0f;
+      }
+      if (flips) {
+        continue;
+      }
+
+      // from is no seam, so it has exactly one vertex
+      for (uint32_t i = offsets[collapse.from]; i < offsets[collapse.from + 1];
+           i++) {
+        for (int k = 0; k < 3; k++) {
+          uint32_t vertex = result[triangles[i] * 3 + k];
+          uint32_t p = positionOf[vertex];
+          if (p == collapse.from) {
+            remap[vertex] = collapse.toVertex;
+          }
+          touched[p] = true;
+        }
+      }
+      quadrics[collapse.to] += quadrics[collapse.from];
+      reachedError = std::max(reachedError, collapse.error);
+      applied++;
+    }
+    if (applied == 0) {
+      break;
+    }
+
+    std::vector<uint32_t> next;
+    next.reserve(result.size());
+    for (size_t i = 0; i + 2 < result.size(); i += 3) {
+      uint32_t a = remap[result[i]];
+      uint32_t b = remap[result[i + 1]];
+      uint32_t c = remap[result[i + 2]];
+      if (positionOf[a] != positionOf[b] && positionOf[b] != positionOf[c] &&
+          positionOf[c] != positionOf[a]) {
+        next.insert(next.end(), {a, b, c});
+      }
+    }
+    result = std::move(next);
+  }
+
+  if (resultError) {
+    *resultError = std::sqrt(reachedError);
+  }
+  return result;
+}
+
+std::vector<MeshLod> generateLods(const MeshData &mesh, size_t maxLevels,
+                                  float reduction, float maxRelativeError) {
+  std::vector<MeshLod> lods;
+  lods.push_back({mesh.indices, 0.0f});
+  if (mesh.vertices.empty()) {
+    return lods;
+  }
+
+  float boxMin[3], boxMax[3];
+  for (int k = 0; k < 3; k++) {
+    boxMin[k] = boxMax[k] = mesh.vertices[0].position[k];
+  }
+  for (const auto &vertex : mesh.vertices) {
+    for (int k = 0; k < 3; k++) {
+      boxMin[k] = std::min(boxMin[k], vertex.position[k]);
+      boxMax[k] = std::max(boxMax[k], vertex.position[k]);
+    }
+  }
+  float diagonal = std::sqrt((boxMax[0] - boxMin[0]) * (boxMax[0] - boxMin[0]) +
+                             (boxMax[1] - boxMin[1]) * (boxMax[1] - boxMin[1]) +
+                             (boxMax[2] - boxMin[2]) * (boxMax[2] - boxMin[2]));
+
+  while (lods.size() < maxLevels) {
+    const MeshLod &previous = lods.back();
+    size_t target = (size_t)(previous.indices.size() / 3 * reduction) * 3;
+
+    float error = 0.0f;
+    auto indices = simplifyMesh(mesh.indices, mesh.vertices, target,
+                                diagonal * maxRelativeError, &error);
+    // Less than a tenth fewer triangles is not worth another level
+    if (indices.size() * 10 > previous.indices.size() * 9) {
+      break;
+    }
+    optimizeVertexCache(indices, mesh.vertices.size());
+    lods.push_back({std::move(indices), std::max(error, previous.error)});
+  }
+  return lods;
+}
+} // namespace toffoo::asset
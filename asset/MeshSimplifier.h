@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Mesh.h"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace toffoo::asset {
+// Collapses edges in order of their quadric error (Garland and Heckbert) until
+// the index count drops to targetIndexCount or the next collapse would move
+// the surface by more than maxError. Vertices on open borders and attribute
+// seams stay in place, so the result indexes the unchanged vertices and only
+// needs a new index range. resultError receives the deviation reached, in the
+// units of the vertex positions.
+std::vector<uint32_t>
+simplifyMesh(const std::vector<uint32_t> &indices,
+             const std::vector<MeshVertex> &vertices, size_t targetIndexCount,
+             float maxError = std::numeric_limits<float>::max(),
+             float *resultError = nullptr);
+
+struct MeshLod {
+  std::vector<uint32_t> indices;
+  // Deviation from the full mesh in the units of the vertex positions, never
+  // smaller than the one of the previous level
+  float error;
+};
+
+// Level 0 is the mesh itself, every further level keeps about reduction of the
+// triangles of the previous one and is optimized for the vertex cache. Stops
+// early once simplification stalls or the deviation would exceed
+// maxRelativeError of the bounding box diagonal.
+std::vector<MeshLod> generateLods(const MeshData &mesh, size_t maxLevels = 4,
+                                  float reduction = 0.5f,
+                                  float maxRelativeError = 0.05f);
+} // namespace toffoo::asset
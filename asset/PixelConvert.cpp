@@ -0,0 +1,135 @@
+#include "PixelConvert.h"
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOFFOO_X86 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace toffoo::asset {
+static void rgbToRgbaScalar(const uint8_t *src, uint8_t *dst, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    dst[i * 4 + 0] = src[i * 3 + 0];
+    dst[i * 4 + 1] = src[i * 3 + 1];
+    dst[i * 4 + 2] = src[i * 3 + 2];
+    dst[i * 4 + 3] = 255;
+  }
+}
+
+#ifdef TOFFOO_X86
+// Spreads the 12 bytes of 4 RGB pixels over 16 bytes, the alpha bytes are
+// zeroed by the shuffle and set by the or
+#define TOFFOO_RGB_SHUFFLE 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+
+__attribute__((target("ssse3"))) static void
+rgbToRgbaSsse3(const uint8_t *src, uint8_t *dst, size_t count) {
+  const __m128i shuffle = _mm_setr_epi8(TOFFOO_RGB_SHUFFLE);
+  const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+  // 16 pixels are exactly three loads
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(src + i * 3));
+    __m128i b = _mm_loadu_si128((const __m128i *)(src + i * 3 + 16));
+    __m128i c = _mm_loadu_si128((const __m128i *)(src + i * 3 + 32));
+
+    __m128i pixels[4] = {a, _mm_alignr_epi8(b, a, 12),
+                         _mm_alignr_epi8(c, b, 8), _mm_srli_si128(c, 4)};
+
+    __m128i *out = (__m128i *)(dst + i * 4);
+    for (int j = 0; j < 4; j++) {
+      _mm_storeu_si128(
+          out + j, _mm_or_si128(_mm_shuffle_epi8(pixels[j], shuffle), alpha));
+    }
+  }
+  rgbToRgbaScalar(src + i * 3, dst + i * 4, count - i);
+}
+
+__attribute__((target("avx2"))) static void
+rgbToRgbaAvx2(const uint8_t *src, uint8_t *dst, size_t count) {
+  const __m256i shuffle =
+      _mm256_setr_epi8(TOFFOO_RGB_SHUFFLE, TOFFOO_RGB_SHUFFLE);
+  const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+
+  // Each lane takes 4 pixels from its own 16 byte load, the last load of an
+  // iteration reads 4 bytes past the 16 pixels, hence the extra 2 pixels
+  size_t i = 0;
+  for (; i + 18 <= count; i += 16) {
+    const uint8_t *in = src + i * 3;
+    __m256i p01 = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)in)),
+        _mm_loadu_si128((const __m128i *)(in + 12)), 1);
+    __m256i p23 = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(in + 24))),
+        _mm_loadu_si128((const __m128i *)(in + 36)), 1);
+
+    __m256i *out = (__m256i *)(dst + i * 4);
+    _mm256_storeu_si256(
+        out + 0, _mm256_or_si256(_mm256_shuffle_epi8(p01, shuffle), alpha));
+    _mm256_storeu_si256(
+        out + 1, _mm256_or_si256(_mm256_shuffle_epi8(p23, shuffle), alpha));
+  }
+  rgbToRgbaSsse3(src + i * 3, dst + i * 4, count - i);
+}
+#undef TOFFOO_RGB_SHUFFLE
+#endif
+
+#ifdef __ARM_NEON
+static void rgbToRgbaNeon(const uint8_t *src, uint8_t *dst, size_t count) {
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    uint8x16x3_t rgb = vld3q_u8(src + i * 3);
+    uint8x16x4_t rgba = {rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(255)};
+    vst4q_u8(dst + i * 4, rgba);
+  }
+  rgbToRgbaScalar(src + i * 3, dst + i * 4, count - i);
+}
+#endif
+
+using RgbToRgba = void (*)(const uint8_t *, uint8_t *, size_t);
+
+static RgbToRgba selectRgbToRgba() {
+#if defined(TOFFOO_X86)
+  if (__builtin_cpu_supports("avx2")) {
+    return rgbToRgbaAvx2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return rgbToRgbaSsse3;
+  }
+#elif defined(__ARM_NEON)
+  return rgbToRgbaNeon;
+#endif
+  return rgbToRgbaScalar;
+}
+
+void convertToRgba(const uint8_t *src, int channels, uint8_t *dst,
+                   size_t pixelCount) {
+  static const RgbToRgba rgbToRgba = selectRgbToRgba();
+
+  switch (channels) {
+  case 1:
+    for (size_t i = 0; i < pixelCount; i++) {
+      dst[i * 4 + 0] = dst[i * 4 + 1] = dst[i * 4 + 2] = src[i];
+      dst[i * 4 + 3] = 255;
+    }
+    break;
+  case 2:
+    for (size_t i = 0; i < pixelCount; i++) {
+      dst[i * 4 + 0] = dst[i * 4 + 1] = dst[i * 4 + 2] = src[i * 2];
+      dst[i * 4 + 3] = src[i * 2 + 1];
+    }
+    break;
+  case 3:
+    rgbToRgba(src, dst, pixelCount);
+    break;
+  case 4:
+    memcpy(dst, src, pixelCount * 4);
+    break;
+  default:
+    throw std::invalid_argument("unsupported channel count!");
+  }
+}
+} // namespace toffoo::asset
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace toffoo::asset {
+// Expands 8-bit grey, grey+alpha, RGB or RGBA pixels to RGBA8, opaque where
+// the source has no alpha. RGB uses the widest SIMD kernel the CPU supports,
+// so decoders can write their native output straight into mapped staging
+// memory instead of expanding it on the scalar path first.
+void convertToRgba(const uint8_t *src, int channels, uint8_t *dst,
+                   size_t pixelCount);
+} // namespace toffoo::asset
@@ -0,0 +1,319 @@
+#include "ResidencyManager.h"
+#include "../vk/CommandBuffers.h"
+#include "../vk/Device.h"
+#include "../vk/Fence.h"
+#include "../vk/Image.h"
+#include "TextureStreamer.h"
+#include <algorithm>
+
+namespace toffoo::asset {
+// Below this the top mip is not worth a copy
+static const uint32_t minTrimExtent = 64;
+
+ResidencyManager::ResidencyManager(std::shared_ptr<vk::Device> device,
+                                   std::shared_ptr<vk::CommandPool> commandPool,
+                                   std::shared_ptr<TextureStreamer> streamer,
+                                   VkDeviceSize budgetOverride,
+                                   float budgetFraction,
+                                   uint32_t framesInFlight,
+                                   uint32_t evictAfterFrames)
+    : device(device), commandPool(commandPool), streamer(streamer),
+      budgetOverride(budgetOverride), budgetFraction(budgetFraction),
+      framesInFlight(framesInFlight), evictAfterFrames(evictAfterFrames) {}
+
+std::shared_ptr<StreamedTexture>
+ResidencyManager::load(const std::string &path) {
+  auto texture = streamer->load(path);
+
+  Entry &entry = entries[texture.get()];
+  entry.path = path;
+  entry.texture = texture;
+  entry.image = texture->get();
+  entry.lastUsed = frame;
+
+  return texture;
+}
+
+void ResidencyManager::use(const std::shared_ptr<StreamedTexture> &texture) {
+  auto it = entries.find(texture.get());
+  if (it == entries.end()) {
+    return;
+  }
+
+  it->second.lastUsed = frame;
+  if (texture->state == StreamedTexture::State::Evicted) {
+    streamer->reload(texture, it->second.path);
+  }
+}
+
+void ResidencyManager::queryBudget(VkDeviceSize &budget, VkDeviceSize &usage) {
+  bool hasBudget =
+      device->isExtensionEnabled(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT};
+  VkPhysicalDeviceMemoryProperties2 properties{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+      .pNext = hasBudget ? &budgetProperties : nullptr};
+  vkGetPhysicalDeviceMemoryProperties2(device->getPhysicalDevice(),
+                                       &properties);
+
+  VkDeviceSize retiredSize = 0;
+  for (auto &item : retired) {
+    retiredSize += item.image->getMemorySize();
+  }
+
+  budget = 0;
+  usage = 0;
+  const auto &memory = properties.memoryProperties;
+  for (uint32_t i = 0; i < memory.memoryHeapCount; i++) {
+    if (!(memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+      continue;
+    }
+    if (hasBudget) {
+      budget += budgetProperties.heapBudget[i];
+      usage += budgetProperties.heapUsage[i];
+    } else {
+      budget += memory.memoryHeaps[i].size;
+    }
+  }
+  budget = (VkDeviceSize)(budget * budgetFraction);
+
+  if (budgetOverride > 0) {
+    budget = budgetOverride;
+  }
+  // The driver usage covers everything on the heaps, otherwise only the
+  // textures are known. Retired images are about to be freed either way.
+  if (!hasBudget || budgetOverride > 0) {
+    usage = resident;
+  } else {
+    usage -= std::min(usage, retiredSize);
+  }
+}
+
+// Replaced images may still be referenced by frames in flight
+void ResidencyManager::retire(std::shared_ptr<vk::Image> image) {
+  if (image && image != streamer->getPlaceholder()) {
+    retired.push_back({frame, image});
+  }
+}
+
+std::vector<ResidencyManager::Entry *>
+ResidencyManager::getLeastRecentlyUsed() {
+  std::vector<Entry *> order;
+  for (auto &[key, entry] : entries) {
+    order.push_back(&entry);
+  }
+  std::sort(order.begin(), order.end(), [](Entry *a, Entry *b) {
+    return a->lastUsed < b->lastUsed;
+  });
+  return order;
+}
+
+size_t ResidencyManager::evict(VkDeviceSize &usage, VkDeviceSize target) {
+  size_t changed = 0;
+  for (Entry *entry : getLeastRecentlyUsed()) {
+    if (usage <= target || frame - entry->lastUsed < evictAfterFrames) {
+      break;
+    }
+    if (entry->texture->state != StreamedTexture::State::Ready ||
+        entry->trimming) {
+      continue;
+    }
+
+    usage -= std::min(usage, entry->image->getMemorySize());
+    retire(entry->image);
+    entry->image = streamer->getPlaceholder();
+    entry->texture->image = entry->image;
+    entry->texture->state = StreamedTexture::State::Evicted;
+    changed++;
+  }
+  return changed;
+}
+
+// Drops the top mip by copying the remaining levels into a new image, the
+// swap happens in update() once the copy finished
+void ResidencyManager::trim(VkDeviceSize &usage, VkDeviceSize target) {
+  Trim batch{vk::createCommandBuffers(device, commandPool, 1),
+             vk::createFence(device),
+             {}};
+
+  VkCommandBuffer cb = batch.commandBuffers->get(0);
+  batch.commandBuffers->begin(0);
+
+  for (Entry *entry : getLeastRecentlyUsed()) {
+    if (usage <= target) {
+      break;
+    }
+
+    auto &old = entry->image;
+    VkExtent2D extent = old->getExtent();
+    if (entry->texture->state != StreamedTexture::State::Ready ||
+        entry->trimming || old->getMipLevels() < 2 ||
+        std::max(extent.width, extent.height) <= minTrimExtent) {
+      continue;
+    }
+
+    uint32_t mipLevels = old->getMipLevels() - 1;
+    auto image = std::make_shared<vk::Image>(
+        device, std::max(extent.width >> 1, 1u),
+        std::max(extent.height >> 1, 1u), old->getFormat(),
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+            VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mipLevels);
+
+    std::vector<VkImageCopy> regions;
+    for (uint32_t i = 0; i < mipLevels; i++) {
+      regions.push_back(
+          {.srcSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                              .mipLevel = i + 1,
+                              .layerCount = 1},
+           .dstSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                              .mipLevel = i,
+                              .layerCount = 1},
+           .extent = {std::max(extent.width >> (i + 1), 1u),
+                      std::max(extent.height >> (i + 1), 1u), 1}});
+    }
+
+    // The old image stays readable for frames submitted before the swap
+    vk::Image::recordLayoutTransition(
+        cb, old->handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, old->getMipLevels());
+    vk::Image::recordLayoutTransition(cb, image->handle(),
+                                      VK_IMAGE_LAYOUT_UNDEFINED,
+                                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                      mipLevels);
+    vkCmdCopyImage(cb, old->handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   image->handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   regions.size(), regions.data());
+    vk::Image::recordLayoutTransition(
+        cb, old->handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, old->getMipLevels());
+    vk::Image::recordLayoutTransition(cb, image->handle(),
+                                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                      mipLevels);
+
+    usage -= std::min(usage, old->getMemorySize() - image->getMemorySize());
+    entry->trimming = true;
+    batch.images.push_back({entry, image});
+  }
+
+  batch.commandBuffers->end(0);
+  if (batch.images.empty()) {
+    return;
+  }
+  batch.commandBuffers->submit(0, *batch.fence);
+  trims.push_back(std::move(batch));
+}
+
+// Trimmed textures in use get their full chain back, most recent first
+void ResidencyManager::reload(VkDeviceSize usage, VkDeviceSize target) {
+  auto order = getLeastRecentlyUsed();
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    Entry *entry = *it;
+    if (frame - entry->lastUsed >= evictAfterFrames) {
+      break;
+    }
+    if (entry->texture->state != StreamedTexture::State::Ready ||
+        entry->trimming || entry->image->getMemorySize() >= entry->fullSize) {
+      continue;
+    }
+
+    VkDeviceSize cost = entry->fullSize - entry->image->getMemorySize();
+    if (usage + cost > target) {
+      break;
+    }
+    usage += cost;
+    streamer->reload(entry->texture, entry->path);
+  }
+}
+
+size_t ResidencyManager::update() {
+  frame++;
+  size_t changed = 0;
+
+  std::erase_if(retired, [this](const Retired &item) {
+    return frame - item.frame > framesInFlight;
+  });
+
+  for (auto it = trims.begin(); it != trims.end();) {
+    if (!it->fence->isSignaled()) {
+      ++it;
+      continue;
+    }
+
+    for (auto &[entry, image] : it->images) {
+      retire(entry->image);
+      entry->image = image;
+      entry->texture->image = image;
+      entry->trimming = false;
+      changed++;
+    }
+    it = trims.erase(it);
+  }
+
+  resident = 0;
+  for (auto it = entries.begin(); it != entries.end();) {
+    Entry &entry = it->second;
+
+    // Promoted by the streamer since the last update
+    if (entry.texture->image != entry.image) {
+      retire(entry.image);
+      entry.image = entry.texture->image;
+      if (entry.texture->state == StreamedTexture::State::Ready) {
+        entry.fullSize = entry.image->getMemorySize();
+      }
+    }
+
+    // Nobody but the manager holds the texture anymore
+    if (entry.texture.use_count() == 1 && !entry.trimming) {
+      retire(entry.image);
+      it = entries.erase(it);
+      continue;
+    }
+
+    if (entry.image != streamer->getPlaceholder()) {
+      resident += entry.image->getMemorySize();
+    }
+    ++it;
+  }
+
+  VkDeviceSize budget, usage;
+  queryBudget(budget, usage);
+
+  // Wait for pending trims to land before judging the budget again
+  if (!trims.empty()) {
+    return changed;
+  }
+
+  if (usage > budget) {
+    changed += evict(usage, budget);
+    trim(usage, budget);
+  } else {
+    // Headroom so a reload does not immediately trigger the next trim
+    reload(usage, budget - budget / 16);
+  }
+
+  return changed;
+}
+
+VkDeviceSize ResidencyManager::getResidentSize() { return resident; }
+
+ResidencyManager::~ResidencyManager() {
+  for (auto &batch : trims) {
+    batch.fence->wait();
+  }
+}
+
+std::shared_ptr<ResidencyManager>
+createResidencyManager(std::shared_ptr<vk::Device> device,
+                       std::shared_ptr<vk::CommandPool> commandPool,
+                       std::shared_ptr<TextureStreamer> streamer,
+                       VkDeviceSize budgetOverride) {
+  return std::make_shared<ResidencyManager>(device, commandPool, streamer,
+                                            budgetOverride);
+}
+} // namespace toffoo::asset
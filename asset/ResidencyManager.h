@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class CommandPool;
+class CommandBuffers;
+class Fence;
+class Image;
+} // namespace toffoo::vk
+
+namespace toffoo::asset {
+class StreamedTexture;
+class TextureStreamer;
+
+// Keeps streamed textures within the device local memory budget. Textures that
+// were not used for a while are evicted to the placeholder, the ones still in
+// use lose their top mip, least recently used first. Evicted textures reload
+// when they are used again, trimmed ones once there is room again.
+class ResidencyManager {
+private:
+  struct Entry {
+    std::string path;
+    std::shared_ptr<StreamedTexture> texture;
+    // Last image seen on the texture, replaced ones are retired
+    std::shared_ptr<vk::Image> image;
+    VkDeviceSize fullSize = 0;
+    uint64_t lastUsed = 0;
+    bool trimming = false;
+  };
+
+  struct Trim {
+    std::shared_ptr<vk::CommandBuffers> commandBuffers;
+    std::shared_ptr<vk::Fence> fence;
+    std::vector<std::pair<Entry *, std::shared_ptr<vk::Image>>> images;
+  };
+
+  struct Retired {
+    uint64_t frame;
+    std::shared_ptr<vk::Image> image;
+  };
+
+  std::shared_ptr<vk::Device> device;
+  std::shared_ptr<vk::CommandPool> commandPool;
+  std::shared_ptr<TextureStreamer> streamer;
+
+  VkDeviceSize budgetOverride;
+  float budgetFraction;
+  uint32_t framesInFlight;
+  uint32_t evictAfterFrames;
+
+  uint64_t frame = 0;
+  VkDeviceSize resident = 0;
+
+  std::unordered_map<StreamedTexture *, Entry> entries;
+  std::vector<Trim> trims;
+  std::vector<Retired> retired;
+
+  void queryBudget(VkDeviceSize &budget, VkDeviceSize &usage);
+
+  void retire(std::shared_ptr<vk::Image> image);
+
+  std::vector<Entry *> getLeastRecentlyUsed();
+
+  size_t evict(VkDeviceSize &usage, VkDeviceSize target);
+
+  void trim(VkDeviceSize &usage, VkDeviceSize target);
+
+  void reload(VkDeviceSize usage, VkDeviceSize target);
+
+public:
+  // Without an override the budget is budgetFraction of what the driver
+  // reports through VK_EXT_memory_budget, or of the device local heaps when
+  // the extension is missing
+  ResidencyManager(std::shared_ptr<vk::Device> device,
+                   std::shared_ptr<vk::CommandPool> commandPool,
+                   std::shared_ptr<TextureStreamer> streamer,
+                   VkDeviceSize budgetOverride = 0, float budgetFraction = 0.9f,
+                   uint32_t framesInFlight = 3,
+                   uint32_t evictAfterFrames = 120);
+
+  std::shared_ptr<StreamedTexture> load(const std::string &path);
+
+  // Marks the texture as used by the current frame, evicted ones start
+  // reloading right away
+  void use(const std::shared_ptr<StreamedTexture> &texture);
+
+  // Call once per frame after TextureStreamer::update. Returns how many
+  // textures changed their image, descriptors referencing them need updates.
+  size_t update();
+
+  VkDeviceSize getResidentSize();
+
+  ~ResidencyManager();
+};
+
+std::shared_ptr<ResidencyManager>
+createResidencyManager(std::shared_ptr<vk::Device> device,
+                       std::shared_ptr<vk::CommandPool> commandPool,
+                       std::shared_ptr<TextureStreamer> streamer,
+                       VkDeviceSize budgetOverride = 0);
+} // namespace toffoo::asset
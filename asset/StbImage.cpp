@@ -0,0 +1,3 @@
+// The one translation unit of the engine and its tools that compiles stb_image
+#define STB_IMAGE_IMPLEMENTATION
+#include "../thirdparty/stb_image.h"
@@ -0,0 +1,371 @@
+#include "TextureLoader.h"
+#include "../vk/Buffer.h"
+#include "../vk/Device.h"
+#include "../vk/Image.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace toffoo::asset {
+static const uint8_t ktx2Identifier[12] = {0xAB, 'K',  'T',  'X', ' ',  '2',
+                                           '0',  0xBB, '\r', '\n', 0x1A, '\n'};
+
+static const char ddsMagic[4] = {'D', 'D', 'S', ' '};
+
+static const size_t ktx2HeaderSize = 80;
+static const size_t ddsHeaderSize = 128;
+static const size_t ddsDx10HeaderSize = 20;
+
+std::vector<char> readFile(const std::string &path, size_t maxSize) {
+  std::ifstream file(path, std::ios::ate | std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("failed to open " + path + "!");
+  }
+
+  size_t fileSize = std::min((size_t)file.tellg(), maxSize);
+  std::vector<char> buffer(fileSize);
+  file.seekg(0);
+  file.read(buffer.data(), fileSize);
+  return buffer;
+}
+
+template <typename T>
+static T readAt(const std::vector<char> &data, size_t offset) {
+  if (offset + sizeof(T) > data.size()) {
+    throw std::runtime_error("texture file is truncated!");
+  }
+  T value;
+  memcpy(&value, data.data() + offset, sizeof(T));
+  return value;
+}
+
+static uint32_t fourCC(const char (&code)[5]) {
+  return code[0] | (code[1] << 8) | (code[2] << 16) | (code[3] << 24);
+}
+
+static VkFormat fromDxgiFormat(uint32_t dxgiFormat) {
+  switch (dxgiFormat) {
+  case 28:
+    return VK_FORMAT_R8G8B8A8_UNORM;
+  case 29:
+    return VK_FORMAT_R8G8B8A8_SRGB;
+  case 71:
+    return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+  case 72:
+    return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+  case 74:
+    return VK_FORMAT_BC2_UNORM_BLOCK;
+  case 75:
+    return VK_FORMAT_BC2_SRGB_BLOCK;
+  case 77:
+    return VK_FORMAT_BC3_UNORM_BLOCK;
+  case 78:
+    return VK_FORMAT_BC3_SRGB_BLOCK;
+  case 80:
+    return VK_FORMAT_BC4_UNORM_BLOCK;
+  case 81:
+    return VK_FORMAT_BC4_SNORM_BLOCK;
+  case 83:
+    return VK_FORMAT_BC5_UNORM_BLOCK;
+  case 84:
+    return VK_FORMAT_BC5_SNORM_BLOCK;
+  case 87:
+    return VK_FORMAT_B8G8R8A8_UNORM;
+  case 91:
+    return VK_FORMAT_B8G8R8A8_SRGB;
+  case 95:
+    return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+  case 96:
+    return VK_FORMAT_BC6H_SFLOAT_BLOCK;
+  case 98:
+    return VK_FORMAT_BC7_UNORM_BLOCK;
+  case 99:
+    return VK_FORMAT_BC7_SRGB_BLOCK;
+  default:
+    return VK_FORMAT_UNDEFINED;
+  }
+}
+
+// Legacy headers carry no color space, the data is taken as UNORM
+static VkFormat fromFourCC(uint32_t code) {
+  if (code == fourCC("DXT1")) {
+    return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+  }
+  if (code == fourCC("DXT3")) {
+    return VK_FORMAT_BC2_UNORM_BLOCK;
+  }
+  if (code == fourCC("DXT5")) {
+    return VK_FORMAT_BC3_UNORM_BLOCK;
+  }
+  if (code == fourCC("ATI1") || code == fourCC("BC4U")) {
+    return VK_FORMAT_BC4_UNORM_BLOCK;
+  }
+  if (code == fourCC("ATI2") || code == fourCC("BC5U")) {
+    return VK_FORMAT_BC5_UNORM_BLOCK;
+  }
+  return VK_FORMAT_UNDEFINED;
+}
+
+// Bytes per 4x4 block, or per texel for the uncompressed formats
+static size_t getLevelSize(VkFormat format, uint32_t width, uint32_t height) {
+  size_t blocks = ((width + 3) / 4) * ((height + 3) / 4);
+  switch (format) {
+  case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+  case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+  case VK_FORMAT_BC4_UNORM_BLOCK:
+  case VK_FORMAT_BC4_SNORM_BLOCK:
+    return blocks * 8;
+  case VK_FORMAT_R8G8B8A8_UNORM:
+  case VK_FORMAT_R8G8B8A8_SRGB:
+  case VK_FORMAT_B8G8R8A8_UNORM:
+  case VK_FORMAT_B8G8R8A8_SRGB:
+    return (size_t)width * height * 4;
+  default:
+    return blocks * 16;
+  }
+}
+
+static VkFormat readDdsFormat(const std::vector<char> &data,
+                              bool &hasDx10Header) {
+  if (data.size() < sizeof(ddsMagic) ||
+      memcmp(data.data(), ddsMagic, sizeof(ddsMagic)) != 0) {
+    throw std::runtime_error("not a DDS file!");
+  }
+
+  const uint32_t pixelFormatFourCC = 0x4;
+  const uint32_t pixelFormatRgb = 0x40;
+
+  uint32_t flags = readAt<uint32_t>(data, 80);
+  uint32_t code = readAt<uint32_t>(data, 84);
+  hasDx10Header = (flags & pixelFormatFourCC) && code == fourCC("DX10");
+
+  VkFormat format = VK_FORMAT_UNDEFINED;
+  if (hasDx10Header) {
+    format = fromDxgiFormat(readAt<uint32_t>(data, ddsHeaderSize));
+  } else if (flags & pixelFormatFourCC) {
+    format = fromFourCC(code);
+  } else if ((flags & pixelFormatRgb) && readAt<uint32_t>(data, 88) == 32) {
+    bool bgra = readAt<uint32_t>(data, 92) == 0x00ff0000;
+    format = bgra ? VK_FORMAT_B8G8R8A8_UNORM : VK_FORMAT_R8G8B8A8_UNORM;
+  }
+
+  if (format == VK_FORMAT_UNDEFINED) {
+    throw std::runtime_error("unsupported DDS pixel format!");
+  }
+  return format;
+}
+
+static VkFormat readKtx2Format(const std::vector<char> &data) {
+  if (data.size() < sizeof(ktx2Identifier) ||
+      memcmp(data.data(), ktx2Identifier, sizeof(ktx2Identifier)) != 0) {
+    throw std::runtime_error("not a KTX2 file!");
+  }
+  return (VkFormat)readAt<uint32_t>(data, 12);
+}
+
+static TextureData parseKtx2(std::vector<char> file) {
+  TextureData texture{};
+  texture.data = std::move(file);
+  auto &data = texture.data;
+
+  texture.format = readKtx2Format(data);
+  texture.width = readAt<uint32_t>(data, 20);
+  texture.height = readAt<uint32_t>(data, 24);
+  uint32_t depth = readAt<uint32_t>(data, 28);
+  uint32_t layerCount = readAt<uint32_t>(data, 32);
+  uint32_t faceCount = readAt<uint32_t>(data, 36);
+  uint32_t levelCount = std::max(readAt<uint32_t>(data, 40), 1u);
+  uint32_t supercompression = readAt<uint32_t>(data, 44);
+
+  if (supercompression != 0) {
+    throw std::runtime_error("supercompressed KTX2 files are not supported!");
+  }
+  // Basis Universal payloads leave the format undefined until transcoded
+  if (texture.format == VK_FORMAT_UNDEFINED) {
+    throw std::runtime_error("KTX2 files without a Vulkan format are not "
+                             "supported!");
+  }
+  if (depth > 1 || layerCount > 1 || faceCount != 1) {
+    throw std::runtime_error("only 2D KTX2 textures are supported!");
+  }
+
+  for (uint32_t i = 0; i < levelCount; i++) {
+    size_t entry = ktx2HeaderSize + i * 3 * sizeof(uint64_t);
+    TextureLevel level{(size_t)readAt<uint64_t>(data, entry),
+                       (size_t)readAt<uint64_t>(data, entry + 8)};
+    if (level.offset + level.size > data.size()) {
+      throw std::runtime_error("texture file is truncated!");
+    }
+    texture.levels.push_back(level);
+  }
+
+  return texture;
+}
+
+static TextureData parseDds(const std::vector<char> &data) {
+  TextureData texture{};
+
+  bool hasDx10Header;
+  texture.format = readDdsFormat(data, hasDx10Header);
+  texture.height = readAt<uint32_t>(data, 12);
+  texture.width = readAt<uint32_t>(data, 16);
+  uint32_t levelCount = std::max(readAt<uint32_t>(data, 28), 1u);
+
+  if (hasDx10Header && readAt<uint32_t>(data, ddsHeaderSize + 12) > 1) {
+    throw std::runtime_error("only 2D DDS textures are supported!");
+  }
+
+  // Levels are packed right after the header, strip it so every level offset
+  // keeps the block alignment vkCmdCopyBufferToImage needs
+  size_t headerSize = ddsHeaderSize + (hasDx10Header ? ddsDx10HeaderSize : 0);
+  size_t offset = 0;
+  for (uint32_t i = 0; i < levelCount; i++) {
+    size_t size = getLevelSize(texture.format, std::max(texture.width >> i, 1u),
+                               std::max(texture.height >> i, 1u));
+    texture.levels.push_back({offset, size});
+    offset += size;
+  }
+
+  if (headerSize + offset > data.size()) {
+    throw std::runtime_error("texture file is truncated!");
+  }
+  texture.data.assign(data.begin() + headerSize,
+                      data.begin() + headerSize + offset);
+
+  return texture;
+}
+
+static bool hasMagic(const std::vector<char> &data, const void *magic,
+                     size_t size) {
+  return data.size() >= size && memcmp(data.data(), magic, size) == 0;
+}
+
+TextureData loadKtx2(const std::string &path) {
+  return parseKtx2(readFile(path));
+}
+
+TextureData loadDds(const std::string &path) {
+  return parseDds(readFile(path));
+}
+
+TextureData loadTexture(const std::string &path) {
+  auto texture = parseTexture(readFile(path));
+  if (!texture) {
+    throw std::runtime_error("unknown texture container " + path + "!");
+  }
+  return *texture;
+}
+
+std::optional<TextureData> parseTexture(std::vector<char> &&data) {
+  if (hasMagic(data, ktx2Identifier, sizeof(ktx2Identifier))) {
+    return parseKtx2(std::move(data));
+  }
+  if (hasMagic(data, ddsMagic, sizeof(ddsMagic))) {
+    return parseDds(data);
+  }
+  return std::nullopt;
+}
+
+VkFormat peekTextureFormat(const std::string &path) {
+  if (!std::ifstream(path)) {
+    return VK_FORMAT_UNDEFINED;
+  }
+
+  auto header = readFile(path, ddsHeaderSize + ddsDx10HeaderSize);
+  if (hasMagic(header, ktx2Identifier, sizeof(ktx2Identifier))) {
+    return readKtx2Format(header);
+  }
+  if (!hasMagic(header, ddsMagic, sizeof(ddsMagic))) {
+    return VK_FORMAT_UNDEFINED;
+  }
+
+  // Truncated headers and pixel formats without a Vulkan equivalent
+  try {
+    bool hasDx10Header;
+    return readDdsFormat(header, hasDx10Header);
+  } catch (const std::runtime_error &) {
+    return VK_FORMAT_UNDEFINED;
+  }
+}
+
+bool isFormatSupported(std::shared_ptr<vk::Device> device, VkFormat format) {
+  VkFormatFeatureFlags required =
+      VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT |
+      VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+  VkFormatProperties props;
+  vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice(), format,
+                                      &props);
+  return (props.optimalTilingFeatures & required) == required;
+}
+
+std::optional<TextureData>
+loadSupportedTexture(std::shared_ptr<vk::Device> device,
+                     const std::vector<std::string> &paths) {
+  for (auto &path : paths) {
+    VkFormat format = peekTextureFormat(path);
+    if (format != VK_FORMAT_UNDEFINED && isFormatSupported(device, format)) {
+      return loadTexture(path);
+    }
+  }
+  return std::nullopt;
+}
+
+std::shared_ptr<vk::Image>
+createImage(std::shared_ptr<vk::Device> device,
+            std::shared_ptr<vk::CommandPool> command_pool,
+            const TextureData &texture, const vk::SamplerDesc &samplerDesc) {
+  return createImage(device, command_pool, texture, texture.data, samplerDesc);
+}
+
+std::shared_ptr<vk::Image>
+createImage(std::shared_ptr<vk::Device> device,
+            std::shared_ptr<vk::CommandPool> command_pool,
+            const TextureData &texture, std::span<const char> data,
+            const vk::SamplerDesc &samplerDesc) {
+  auto buf = std::make_shared<vk::Buffer>(
+      device, data.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  memcpy(buf->map(), data.data(), data.size());
+
+  uint32_t mipLevels = texture.levels.size();
+  auto image = std::make_shared<vk::Image>(
+      device, texture.width, texture.height, texture.format,
+      VK_IMAGE_TILING_OPTIMAL,
+      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mipLevels, 1, 0, samplerDesc);
+
+  std::vector<VkBufferImageCopy> regions;
+  for (uint32_t i = 0; i < mipLevels; i++) {
+    regions.push_back(
+        {.bufferOffset = texture.levels[i].offset,
+         .bufferRowLength = 0,
+         .bufferImageHeight = 0,
+         .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                              .mipLevel = i,
+                              .baseArrayLayer = 0,
+                              .layerCount = 1},
+         .imageOffset = {0, 0, 0},
+         .imageExtent = {std::max(texture.width >> i, 1u),
+                         std::max(texture.height >> i, 1u), 1}});
+  }
+
+  vk::Image::transitionImageLayout(device, command_pool, image->handle(),
+                                   texture.format, VK_IMAGE_LAYOUT_UNDEFINED,
+                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   mipLevels);
+
+  vk::Image::copyBufferToImage(device, command_pool, buf, image, regions);
+
+  vk::Image::transitionImageLayout(device, command_pool, image->handle(),
+                                   texture.format,
+                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                   mipLevels);
+
+  return image;
+}
+} // namespace toffoo::asset
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../vk/SamplerCache.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class CommandPool;
+class Image;
+} // namespace toffoo::vk
+
+namespace toffoo::asset {
+struct TextureLevel {
+  size_t offset;
+  size_t size;
+};
+
+// Pre-mipped texture payload as stored in the container, level 0 first
+struct TextureData {
+  VkFormat format;
+  uint32_t width;
+  uint32_t height;
+  std::vector<TextureLevel> levels;
+  std::vector<char> data;
+};
+
+std::vector<char> readFile(const std::string &path, size_t maxSize = SIZE_MAX);
+
+// Only plain 2D textures are supported, no supercompression (zstd/BasisLZ)
+TextureData loadKtx2(const std::string &path);
+
+// BC1-BC7 and RGBA8 through legacy FourCC codes or the DX10 header
+TextureData loadDds(const std::string &path);
+
+// Picks the container by its magic
+TextureData loadTexture(const std::string &path);
+
+// Same as loadTexture for a file already in memory. Returns nullopt and leaves
+// data untouched when it is neither KTX2 nor DDS.
+std::optional<TextureData> parseTexture(std::vector<char> &&data);
+
+// Reads only the header, VK_FORMAT_UNDEFINED if the file is missing, neither
+// KTX2 nor DDS or in a DDS pixel format that is not supported
+VkFormat peekTextureFormat(const std::string &path);
+
+bool isFormatSupported(std::shared_ptr<vk::Device> device, VkFormat format);
+
+// Loads the first candidate whose format the device can sample, so the same
+// asset can ship as e.g. BC7, ASTC and ETC2 variants
+std::optional<TextureData>
+loadSupportedTexture(std::shared_ptr<vk::Device> device,
+                     const std::vector<std::string> &paths);
+
+std::shared_ptr<vk::Image>
+createImage(std::shared_ptr<vk::Device> device,
+            std::shared_ptr<vk::CommandPool> command_pool,
+            const TextureData &texture,
+            const vk::SamplerDesc &samplerDesc = {});
+
+// Uploads level data owned elsewhere, e.g. a mapped archive, straight into the
+// staging buffer. texture.data is ignored, its levels index into data.
+std::shared_ptr<vk::Image>
+createImage(std::shared_ptr<vk::Device> device,
+            std::shared_ptr<vk::CommandPool> command_pool,
+            const TextureData &texture, std::span<const char> data,
+            const vk::SamplerDesc &samplerDesc = {});
+} // namespace toffoo::asset
@@ -0,0 +1,272 @@
+#include "TextureStreamer.h"
+#include "../core/ThreadPool.h"
+#include "../thirdparty/stb_image.h"
+#include "../vk/Buffer.h"
+#include "../vk/CommandBuffers.h"
+#include "../vk/Device.h"
+#include "../vk/Fence.h"
+#include "../vk/Image.h"
+#include "../vk/MipmapGenerator.h"
+#include "PixelConvert.h"
+#include <algorithm>
+#include <cstring>
+
+namespace toffoo::asset {
+std::shared_ptr<vk::Image> StreamedTexture::get() { return image; }
+
+StreamedTexture::State StreamedTexture::getState() { return state; }
+
+TextureStreamer::TextureStreamer(std::shared_ptr<vk::Device> device,
+                                 std::shared_ptr<vk::CommandPool> commandPool,
+                                 std::shared_ptr<core::ThreadPool> threadPool,
+                                 size_t maxBatchSize)
+    : device(device), commandPool(commandPool), threadPool(threadPool),
+      maxBatchSize(maxBatchSize) {
+  uint8_t grey[4] = {128, 128, 128, 255};
+  placeholder = vk::Image::create(device, commandPool, grey, 1, 1);
+
+  ioThread = std::thread(&TextureStreamer::readFiles, this);
+}
+
+std::shared_ptr<StreamedTexture>
+TextureStreamer::load(const std::string &path) {
+  auto texture = std::make_shared<StreamedTexture>();
+  texture->image = placeholder;
+  reload(texture, path);
+  return texture;
+}
+
+void TextureStreamer::reload(std::shared_ptr<StreamedTexture> texture,
+                             const std::string &path) {
+  texture->state = StreamedTexture::State::Loading;
+
+  {
+    std::lock_guard<std::mutex> lock(requestMutex);
+    requests.push({path, texture});
+  }
+  requestCondition.notify_one();
+}
+
+std::shared_ptr<vk::Image> TextureStreamer::getPlaceholder() {
+  return placeholder;
+}
+
+// Reads are kept on a single thread so they stay sequential on disk
+void TextureStreamer::readFiles() {
+  while (true) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(requestMutex);
+      requestCondition.wait(lock,
+                            [this] { return stopping || !requests.empty(); });
+      if (stopping) {
+        return;
+      }
+      request = std::move(requests.front());
+      requests.pop();
+    }
+
+    std::vector<char> file;
+    try {
+      file = readFile(request.path);
+    } catch (const std::exception &) {
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(stagedMutex);
+      decoding++;
+    }
+    threadPool->enqueue(
+        [this, request = std::move(request), file = std::move(file)]() mutable {
+          decode(std::move(request), std::move(file));
+        });
+  }
+}
+
+void TextureStreamer::decode(Request request, std::vector<char> file) {
+  Staged result{request.texture, {}, false, nullptr};
+
+  try {
+    if (auto texture = parseTexture(std::move(file))) {
+      result.staging = std::make_shared<vk::Buffer>(
+          device, texture->data.size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+              VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+      memcpy(result.staging->map(), texture->data.data(),
+             texture->data.size());
+
+      texture->data.clear();
+      result.layout = std::move(*texture);
+    } else if (!file.empty()) {
+      // Decoded in the native channel count, the expansion to RGBA writes
+      // straight into the mapped staging buffer
+      int width, height, channels;
+      stbi_uc *pixels = stbi_load_from_memory(
+          reinterpret_cast<const stbi_uc *>(file.data()), file.size(), &width,
+          &height, &channels, 0);
+      if (pixels) {
+        size_t size = (size_t)width * height * 4;
+        result.staging = std::make_shared<vk::Buffer>(
+            device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        convertToRgba(pixels, channels,
+                      static_cast<uint8_t *>(result.staging->map()),
+                      (size_t)width * height);
+        stbi_image_free(pixels);
+
+        result.layout = {VK_FORMAT_R8G8B8A8_SRGB,
+                         (uint32_t)width,
+                         (uint32_t)height,
+                         {{0, size}},
+                         {}};
+        result.generateMipmaps = true;
+      }
+    }
+  } catch (const std::exception &) {
+    result.staging = nullptr;
+  }
+
+  // Notified under the lock, the destructor may free the condition as soon as
+  // it sees decoding reach zero
+  std::lock_guard<std::mutex> lock(stagedMutex);
+  staged.push_back(std::move(result));
+  decoding--;
+  decodedCondition.notify_all();
+}
+
+void TextureStreamer::submit(std::vector<Staged> uploads) {
+  Batch batch{vk::createCommandBuffers(device, commandPool, 1),
+              vk::createFence(device), nullptr, std::move(uploads), {}};
+
+  VkCommandBuffer cb = batch.commandBuffers->get(0);
+  batch.commandBuffers->begin(0);
+
+  for (auto &upload : batch.uploads) {
+    auto &layout = upload.layout;
+
+    // Transfer source lets ResidencyManager copy out the lower mips
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+                              VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                              VK_IMAGE_USAGE_SAMPLED_BIT;
+    VkImageCreateFlags flags = 0;
+    uint32_t mipLevels = layout.levels.size();
+    if (upload.generateMipmaps) {
+      usage |= vk::MipmapGenerator::getRequiredUsage(device, layout.format);
+      flags |= vk::MipmapGenerator::getRequiredFlags(device, layout.format);
+      mipLevels =
+          vk::MipmapGenerator::getMipLevels(layout.width, layout.height);
+    }
+
+    auto image = std::make_shared<vk::Image>(
+        device, layout.width, layout.height, layout.format,
+        VK_IMAGE_TILING_OPTIMAL, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        mipLevels, 1, flags);
+
+    std::vector<VkBufferImageCopy> regions;
+    for (uint32_t i = 0; i < layout.levels.size(); i++) {
+      regions.push_back(
+          {.bufferOffset = layout.levels[i].offset,
+           .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                .mipLevel = i,
+                                .layerCount = 1},
+           .imageExtent = {std::max(layout.width >> i, 1u),
+                           std::max(layout.height >> i, 1u), 1}});
+    }
+
+    vk::Image::recordLayoutTransition(cb, image->handle(),
+                                      VK_IMAGE_LAYOUT_UNDEFINED,
+                                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                      mipLevels);
+    vkCmdCopyBufferToImage(cb, upload.staging->handle(), image->handle(),
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           regions.size(), regions.data());
+
+    if (upload.generateMipmaps) {
+      if (!batch.mipmapGenerator) {
+        batch.mipmapGenerator = vk::createMipmapGenerator(device);
+      }
+      batch.mipmapGenerator->record(cb, image);
+    } else {
+      vk::Image::recordLayoutTransition(
+          cb, image->handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels);
+    }
+
+    batch.images.push_back(image);
+  }
+
+  batch.commandBuffers->end(0);
+  batch.commandBuffers->submit(0, *batch.fence);
+
+  inFlight.push_back(std::move(batch));
+}
+
+size_t TextureStreamer::update() {
+  size_t changed = 0;
+
+  std::vector<Staged> ready;
+  {
+    std::lock_guard<std::mutex> lock(stagedMutex);
+    ready.swap(staged);
+  }
+
+  std::vector<Staged> uploads;
+  for (auto &item : ready) {
+    if (!item.staging) {
+      item.texture->state = StreamedTexture::State::Failed;
+      changed++;
+      continue;
+    }
+
+    uploads.push_back(std::move(item));
+    if (uploads.size() == maxBatchSize) {
+      submit(std::move(uploads));
+      uploads.clear();
+    }
+  }
+  if (!uploads.empty()) {
+    submit(std::move(uploads));
+  }
+
+  for (auto it = inFlight.begin(); it != inFlight.end();) {
+    if (!it->fence->isSignaled()) {
+      ++it;
+      continue;
+    }
+
+    for (size_t i = 0; i < it->uploads.size(); i++) {
+      it->uploads[i].texture->image = it->images[i];
+      it->uploads[i].texture->state = StreamedTexture::State::Ready;
+      changed++;
+    }
+    it = inFlight.erase(it);
+  }
+
+  return changed;
+}
+
+TextureStreamer::~TextureStreamer() {
+  {
+    std::lock_guard<std::mutex> lock(requestMutex);
+    stopping = true;
+  }
+  requestCondition.notify_all();
+  ioThread.join();
+
+  // Decode tasks still running on the pool reference this streamer
+  std::unique_lock<std::mutex> lock(stagedMutex);
+  decodedCondition.wait(lock, [this] { return decoding == 0; });
+
+  for (auto &batch : inFlight) {
+    batch.fence->wait();
+  }
+}
+
+std::shared_ptr<TextureStreamer>
+createTextureStreamer(std::shared_ptr<vk::Device> device,
+                      std::shared_ptr<vk::CommandPool> commandPool,
+                      std::shared_ptr<core::ThreadPool> threadPool) {
+  return std::make_shared<TextureStreamer>(device, commandPool, threadPool);
+}
+} // namespace toffoo::asset
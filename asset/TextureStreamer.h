@@ -0,0 +1,125 @@
+#pragma once
+
+#include "TextureLoader.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace toffoo::vk {
+class Buffer;
+class CommandBuffers;
+class Fence;
+class MipmapGenerator;
+} // namespace toffoo::vk
+
+namespace toffoo::core {
+class ThreadPool;
+}
+
+namespace toffoo::asset {
+class TextureStreamer;
+
+class ResidencyManager;
+
+// Shows a placeholder until TextureStreamer::update promotes the real image
+class StreamedTexture {
+public:
+  // Evicted textures show the placeholder again until they are reloaded
+  enum class State { Loading, Ready, Failed, Evicted };
+
+private:
+  std::shared_ptr<vk::Image> image;
+  State state = State::Loading;
+
+  friend class TextureStreamer;
+  friend class ResidencyManager;
+
+public:
+  std::shared_ptr<vk::Image> get();
+
+  State getState();
+};
+
+// Loads textures without blocking the render loop. Files are read on an I/O
+// thread, decoded into staging buffers on the thread pool and uploaded in
+// batches; only update() touches the queue and has to run on the render thread.
+class TextureStreamer {
+private:
+  struct Request {
+    std::string path;
+    std::shared_ptr<StreamedTexture> texture;
+  };
+
+  struct Staged {
+    std::shared_ptr<StreamedTexture> texture;
+    TextureData layout;
+    bool generateMipmaps;
+    std::shared_ptr<vk::Buffer> staging;
+  };
+
+  struct Batch {
+    std::shared_ptr<vk::CommandBuffers> commandBuffers;
+    std::shared_ptr<vk::Fence> fence;
+    std::shared_ptr<vk::MipmapGenerator> mipmapGenerator;
+    std::vector<Staged> uploads;
+    std::vector<std::shared_ptr<vk::Image>> images;
+  };
+
+  std::shared_ptr<vk::Device> device;
+  std::shared_ptr<vk::CommandPool> commandPool;
+  std::shared_ptr<core::ThreadPool> threadPool;
+
+  std::shared_ptr<vk::Image> placeholder;
+
+  size_t maxBatchSize;
+
+  std::thread ioThread;
+  std::queue<Request> requests;
+  std::mutex requestMutex;
+  std::condition_variable requestCondition;
+  bool stopping = false;
+
+  std::vector<Staged> staged;
+  size_t decoding = 0;
+  std::mutex stagedMutex;
+  std::condition_variable decodedCondition;
+
+  std::vector<Batch> inFlight;
+
+  void readFiles();
+
+  void decode(Request request, std::vector<char> file);
+
+  void submit(std::vector<Staged> uploads);
+
+public:
+  TextureStreamer(std::shared_ptr<vk::Device> device,
+                  std::shared_ptr<vk::CommandPool> commandPool,
+                  std::shared_ptr<core::ThreadPool> threadPool,
+                  size_t maxBatchSize = 32);
+
+  std::shared_ptr<StreamedTexture> load(const std::string &path);
+
+  // Loads path again into an existing texture, which keeps showing its current
+  // image until the new one is promoted
+  void reload(std::shared_ptr<StreamedTexture> texture,
+              const std::string &path);
+
+  std::shared_ptr<vk::Image> getPlaceholder();
+
+  // Submits staged textures and promotes the ones whose upload finished.
+  // Returns how many textures were promoted or failed since the last call.
+  size_t update();
+
+  ~TextureStreamer();
+};
+
+std::shared_ptr<TextureStreamer>
+createTextureStreamer(std::shared_ptr<vk::Device> device,
+                      std::shared_ptr<vk::CommandPool> commandPool,
+                      std::shared_ptr<core::ThreadPool> threadPool);
+} // namespace toffoo::asset
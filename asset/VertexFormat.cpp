@@ -0,0 +1,254 @@
+#include "VertexFormat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace toffoo::asset {
+namespace {
+struct AttributeLayout {
+  VkFormat format;
+  uint32_t size;
+};
+
+// Three component formats are padded to four, they are rarely supported for
+// vertex input below 32 bits
+AttributeLayout getLayout(AttributeFormat format, uint32_t components) {
+  bool pair = components == 2;
+  switch (format) {
+  case AttributeFormat::Float:
+    return pair ? AttributeLayout{VK_FORMAT_R32G32_SFLOAT, 8}
+                : AttributeLayout{VK_FORMAT_R32G32B32_SFLOAT, 12};
+  case AttributeFormat::Half:
+    return pair ? AttributeLayout{VK_FORMAT_R16G16_SFLOAT, 4}
+                : AttributeLayout{VK_FORMAT_R16G16B16A16_SFLOAT, 8};
+  case AttributeFormat::Snorm8:
+    return pair ? AttributeLayout{VK_FORMAT_R8G8_SNORM, 2}
+                : AttributeLayout{VK_FORMAT_R8G8B8A8_SNORM, 4};
+  case AttributeFormat::Snorm16:
+    return pair ? AttributeLayout{VK_FORMAT_R16G16_SNORM, 4}
+                : AttributeLayout{VK_FORMAT_R16G16B16A16_SNORM, 8};
+  case AttributeFormat::Unorm8:
+    return pair ? AttributeLayout{VK_FORMAT_R8G8_UNORM, 2}
+                : AttributeLayout{VK_FORMAT_R8G8B8A8_UNORM, 4};
+  case AttributeFormat::Unorm16:
+    return pair ? AttributeLayout{VK_FORMAT_R16G16_UNORM, 4}
+                : AttributeLayout{VK_FORMAT_R16G16B16A16_UNORM, 8};
+  case AttributeFormat::Octahedral8:
+    return {VK_FORMAT_R8G8_SNORM, 2};
+  case AttributeFormat::Octahedral16:
+    return {VK_FORMAT_R16G16_SNORM, 4};
+  }
+  throw std::invalid_argument("unknown attribute format!");
+}
+
+// Attributes start 4 byte aligned
+uint32_t getPaddedSize(AttributeFormat format, uint32_t components) {
+  return (getLayout(format, components).size + 3) & ~3u;
+}
+
+bool isOctahedral(AttributeFormat format) {
+  return format == AttributeFormat::Octahedral8 ||
+         format == AttributeFormat::Octahedral16;
+}
+
+bool isUnorm(AttributeFormat format) {
+  return format == AttributeFormat::Unorm8 ||
+         format == AttributeFormat::Unorm16;
+}
+
+bool isNormalized(AttributeFormat format) {
+  return format != AttributeFormat::Float && format != AttributeFormat::Half;
+}
+
+template <typename T> void store(char *dst, float value) {
+  T stored = (T)std::lround(value);
+  memcpy(dst, &stored, sizeof(stored));
+}
+
+// Writes components already in the range of the format
+void encode(char *dst, AttributeFormat format, const float *values,
+            uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    float v = values[i];
+    switch (format) {
+    case AttributeFormat::Float:
+      memcpy(dst + i * 4, &v, 4);
+      break;
+    case AttributeFormat::Half: {
+      uint16_t half = floatToHalf(v);
+      memcpy(dst + i * 2, &half, 2);
+      break;
+    }
+    case AttributeFormat::Snorm8:
+    case AttributeFormat::Octahedral8:
+      store<int8_t>(dst + i, std::clamp(v, -1.0f, 1.0f) * INT8_MAX);
+      break;
+    case AttributeFormat::Snorm16:
+    case AttributeFormat::Octahedral16:
+      store<int16_t>(dst + i * 2, std::clamp(v, -1.0f, 1.0f) * INT16_MAX);
+      break;
+    case AttributeFormat::Unorm8:
+      store<uint8_t>(dst + i, std::clamp(v, 0.0f, 1.0f) * UINT8_MAX);
+      break;
+    case AttributeFormat::Unorm16:
+      store<uint16_t>(dst + i * 2, std::clamp(v, 0.0f, 1.0f) * UINT16_MAX);
+      break;
+    }
+  }
+}
+
+// Projects onto the octahedron |x| + |y| + |z| = 1 and folds the lower half
+// over the diagonals
+void encodeOctahedral(const float *normal, float *out) {
+  float length =
+      std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+  if (length == 0.0f) {
+    out[0] = out[1] = 0.0f;
+    return;
+  }
+  float x = normal[0] / length;
+  float y = normal[1] / length;
+  if (normal[2] < 0.0f) {
+    float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+    float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    x = foldedX;
+    y = foldedY;
+  }
+  out[0] = x;
+  out[1] = y;
+}
+} // namespace
+
+uint16_t floatToHalf(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  uint32_t sign = (bits >> 16) & 0x8000;
+  uint32_t mantissa = bits & 0x7fffff;
+  int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+
+  if (((bits >> 23) & 0xff) == 0xff) {
+    return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+  }
+  if (exponent >= 31) {
+    return sign | 0x7c00;
+  }
+
+  // Rounds to nearest even, a carry out of the mantissa bumps the exponent
+  uint32_t half, rest, halfway;
+  if (exponent <= 0) {
+    if (exponent < -10) {
+      return sign;
+    }
+    uint32_t shift = 14 - exponent;
+    mantissa |= 0x800000;
+    half = mantissa >> shift;
+    rest = mantissa & ((1u << shift) - 1);
+    halfway = 1u << (shift - 1);
+  } else {
+    half = (exponent << 10) | (mantissa >> 13);
+    rest = mantissa & 0x1fff;
+    halfway = 0x1000;
+  }
+  if (rest > halfway || (rest == halfway && (half & 1))) {
+    half++;
+  }
+  return sign | half;
+}
+
+size_t QuantizedMesh::getVertexCount() const {
+  return vertices.size() / stride;
+}
+
+VkVertexInputBindingDescription
+QuantizedMesh::getBindingDescription(uint32_t binding) const {
+  return {.binding = binding,
+          .stride = stride,
+          .inputRate = VK_VERTEX_INPUT_RATE_VERTEX};
+}
+
+std::vector<VkVertexInputAttributeDescription>
+QuantizedMesh::getAttributeDescriptions(uint32_t binding) const {
+  std::vector<VkVertexInputAttributeDescription> attributes;
+  uint32_t offset = 0;
+  uint32_t location = 0;
+  for (auto [attribute, components] :
+       {std::pair{format.position, 3u}, std::pair{format.normal, 3u},
+        std::pair{format.texCoord, 2u}}) {
+    attributes.push_back({.location = location++,
+                          .binding = binding,
+                          .format = getLayout(attribute, components).format,
+                          .offset = offset});
+    offset += getPaddedSize(attribute, components);
+  }
+  return attributes;
+}
+
+QuantizedMesh quantizeMesh(const MeshData &mesh, const VertexFormat &format) {
+  if (isOctahedral(format.position) || isOctahedral(format.texCoord)) {
+    throw std::invalid_argument("octahedral encoding is for normals only!");
+  }
+  if (isUnorm(format.normal)) {
+    throw std::invalid_argument("normals need a signed format!");
+  }
+
+  QuantizedMesh result;
+  result.format = format;
+  result.indices = mesh.indices;
+
+  auto attributes = result.getAttributeDescriptions(0);
+  uint32_t normalOffset = attributes[1].offset;
+  uint32_t texCoordOffset = attributes[2].offset;
+  result.stride = texCoordOffset + getPaddedSize(format.texCoord, 2);
+
+  // Normalized positions span the bounds, around the center for snorm
+  if (isNormalized(format.position) && !mesh.vertices.empty()) {
+    float lower[3], upper[3];
+    for (int k = 0; k < 3; k++) {
+      lower[k] = upper[k] = mesh.vertices[0].position[k];
+    }
+    for (const MeshVertex &vertex : mesh.vertices) {
+      for (int k = 0; k < 3; k++) {
+        lower[k] = std::min(lower[k], vertex.position[k]);
+        upper[k] = std::max(upper[k], vertex.position[k]);
+      }
+    }
+
+    float extent = 0.0f;
+    for (int k = 0; k < 3; k++) {
+      extent = std::max(extent, upper[k] - lower[k]);
+    }
+    bool centered = !isUnorm(format.position);
+    for (int k = 0; k < 3; k++) {
+      result.positionOffset[k] =
+          centered ? (lower[k] + upper[k]) * 0.5f : lower[k];
+    }
+    result.positionScale = extent > 0.0f ? (centered ? extent * 0.5f : extent)
+                                         : 1.0f;
+  }
+
+  result.vertices.resize(mesh.vertices.size() * result.stride);
+  for (size_t i = 0; i < mesh.vertices.size(); i++) {
+    const MeshVertex &vertex = mesh.vertices[i];
+    char *dst = result.vertices.data() + i * result.stride;
+
+    float position[3];
+    for (int k = 0; k < 3; k++) {
+      position[k] = (vertex.position[k] - result.positionOffset[k]) /
+                    result.positionScale;
+    }
+    encode(dst, format.position, position, 3);
+
+    if (isOctahedral(format.normal)) {
+      float folded[2];
+      encodeOctahedral(vertex.normal, folded);
+      encode(dst + normalOffset, format.normal, folded, 2);
+    } else {
+      encode(dst + normalOffset, format.normal, vertex.normal, 3);
+    }
+
+    encode(dst + texCoordOffset, format.texCoord, vertex.texCoord, 2);
+  }
+  return result;
+}
+} // namespace toffoo::asset
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Mesh.h"
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::asset {
+enum class AttributeFormat {
+  Float,
+  Half,
+  // Normalized integers. Positions are mapped to the mesh bounds, normals and
+  // texture coordinates are clamped to [-1, 1] or [0, 1].
+  Snorm8,
+  Snorm16,
+  Unorm8,
+  Unorm16,
+  // Unit vectors folded onto two snorm components, the vertex shader decodes
+  // them (see shaders/mesh.vert)
+  Octahedral8,
+  Octahedral16,
+};
+
+// Storage of each MeshVertex attribute. The default is 16 bytes per vertex
+// instead of the 32 of MeshVertex. 16-bit positions give millimeter precision
+// for meshes up to about 65 meters across.
+struct VertexFormat {
+  AttributeFormat position = AttributeFormat::Unorm16;
+  AttributeFormat normal = AttributeFormat::Octahedral16;
+  AttributeFormat texCoord = AttributeFormat::Half;
+};
+
+// Interleaved vertices ready for a VertexBuffer, position at location 0,
+// normal at 1 and texture coordinates at 2
+struct QuantizedMesh {
+  VertexFormat format;
+  uint32_t stride = 0;
+  std::vector<char> vertices;
+  std::vector<uint32_t> indices;
+  // Normalized positions decode to position * positionScale + positionOffset,
+  // usually folded into the model matrix. The scale is uniform so normals need
+  // no correction.
+  float positionScale = 1.0f;
+  float positionOffset[3] = {};
+
+  size_t getVertexCount() const;
+
+  VkVertexInputBindingDescription getBindingDescription(uint32_t binding) const;
+
+  std::vector<VkVertexInputAttributeDescription>
+  getAttributeDescriptions(uint32_t binding) const;
+};
+
+// Throws for formats that make no sense for an attribute, e.g. octahedral
+// positions or unorm normals
+QuantizedMesh quantizeMesh(const MeshData &mesh, const VertexFormat &format);
+
+uint16_t floatToHalf(float value);
+} // namespace toffoo::asset
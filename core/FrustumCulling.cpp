@@ -0,0 +1,278 @@
+#include "FrustumCulling.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOFFOO_X86 1
+#endif
+
+namespace toffoo::core {
+Frustum Frustum::fromMatrix(const glm::mat4 &viewProj) {
+  auto row = [&](int r) {
+    return glm::vec4(viewProj[0][r], viewProj[1][r], viewProj[2][r],
+                     viewProj[3][r]);
+  };
+
+  Frustum frustum{{row(3) + row(0), row(3) - row(0), row(3) + row(1),
+                   row(3) - row(1), row(3) + row(2), row(3) - row(2)}};
+  for (auto &plane : frustum.planes) {
+    plane /= glm::length(glm::vec3(plane));
+  }
+  return frustum;
+}
+
+void BoundingVolumes::resize(size_t count) {
+  size_t padded = (count + 15) & ~(size_t)15;
+  for (auto *values : {&centerX, &centerY, &centerZ, &minX, &minY, &minZ,
+                       &maxX, &maxY, &maxZ}) {
+    values->resize(padded, 0.0f);
+  }
+  // A negative infinite radius fails every plane
+  radius.resize(padded);
+  std::fill(radius.begin() + std::min(this->count, count), radius.end(),
+            -std::numeric_limits<float>::infinity());
+  this->count = count;
+}
+
+size_t BoundingVolumes::size() { return count; }
+
+void BoundingVolumes::set(size_t idx, const glm::vec3 &center, float radius,
+                          const glm::vec3 &boxMin, const glm::vec3 &boxMax) {
+  centerX[idx] = center.x;
+  centerY[idx] = center.y;
+  centerZ[idx] = center.z;
+  this->radius[idx] = radius;
+  minX[idx] = boxMin.x;
+  minY[idx] = boxMin.y;
+  minZ[idx] = boxMin.z;
+  maxX[idx] = boxMax.x;
+  maxY[idx] = boxMax.y;
+  maxZ[idx] = boxMax.z;
+}
+
+void BoundingVolumes::set(size_t idx, const glm::mat4 &transform,
+                          const glm::vec3 &boxMin, const glm::vec3 &boxMax) {
+  glm::vec3 center(transform * glm::vec4((boxMin + boxMax) * 0.5f, 1.0f));
+  glm::vec3 halfSize = (boxMax - boxMin) * 0.5f;
+
+  // Extent of the transformed box along each world axis (Arvo)
+  glm::vec3 extent(0.0f);
+  float scale = 0.0f;
+  for (int i = 0; i < 3; i++) {
+    glm::vec3 axis(transform[i]);
+    extent += glm::abs(axis) * halfSize[i];
+    scale = std::max(scale, glm::length(axis));
+  }
+  set(idx, center, glm::length(halfSize) * scale, center - extent,
+      center + extent);
+}
+
+namespace {
+// Pointers into BoundingVolumes for the kernels
+struct CullInput {
+  const float *centerX, *centerY, *centerZ, *radius;
+  const float *minX, *minY, *minZ;
+  const float *maxX, *maxY, *maxZ;
+  const Frustum *frustum;
+
+  // The box corner farthest along the plane normal
+  const float *positiveX(const glm::vec4 &plane) const {
+    return plane.x >= 0.0f ? maxX : minX;
+  }
+  const float *positiveY(const glm::vec4 &plane) const {
+    return plane.y >= 0.0f ? maxY : minY;
+  }
+  const float *positiveZ(const glm::vec4 &plane) const {
+    return plane.z >= 0.0f ? maxZ : minZ;
+  }
+};
+
+void appendMask(uint32_t mask, size_t first, std::vector<uint32_t> &visible) {
+  while (mask != 0) {
+    visible.push_back(first + __builtin_ctz(mask));
+    mask &= mask - 1;
+  }
+}
+} // namespace
+
+static void cullScalar(const CullInput &in, size_t begin, size_t end,
+                       std::vector<uint32_t> &visible) {
+  for (size_t i = begin; i < end; i++) {
+    bool inside = true;
+    for (const auto &plane : in.frustum->planes) {
+      float sphere = plane.x * in.centerX[i] + plane.y * in.centerY[i] +
+                     plane.z * in.centerZ[i] + plane.w + in.radius[i];
+      float box = plane.x * in.positiveX(plane)[i] +
+                  plane.y * in.positiveY(plane)[i] +
+                  plane.z * in.positiveZ(plane)[i] + plane.w;
+      inside = inside && sphere >= 0.0f && box >= 0.0f;
+    }
+    if (inside) {
+      visible.push_back(i);
+    }
+  }
+}
+
+#ifdef TOFFOO_X86
+// The kernels differ only in width. Per plane the sphere test is
+// dot(n, center) + d + radius >= 0 and the box test uses the corner farthest
+// along n, picked once per plane since the plane is the same for all lanes.
+__attribute__((target("sse2"))) static void
+cullSse(const CullInput &in, size_t begin, size_t end,
+        std::vector<uint32_t> &visible) {
+  const __m128 zero = _mm_setzero_ps();
+  for (size_t i = begin; i < end; i += 4) {
+    __m128 cx = _mm_loadu_ps(in.centerX + i);
+    __m128 cy = _mm_loadu_ps(in.centerY + i);
+    __m128 cz = _mm_loadu_ps(in.centerZ + i);
+    __m128 r = _mm_loadu_ps(in.radius + i);
+    __m128 inside = _mm_cmpeq_ps(zero, zero);
+
+    for (const auto &plane : in.frustum->planes) {
+      __m128 a = _mm_set1_ps(plane.x);
+      __m128 b = _mm_set1_ps(plane.y);
+      __m128 c = _mm_set1_ps(plane.z);
+      __m128 d = _mm_set1_ps(plane.w);
+
+      __m128 sphere = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(a, cx), _mm_mul_ps(b, cy)),
+          _mm_add_ps(_mm_mul_ps(c, cz), _mm_add_ps(d, r)));
+      __m128 box = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(a, _mm_loadu_ps(in.positiveX(plane) + i)),
+                     _mm_mul_ps(b, _mm_loadu_ps(in.positiveY(plane) + i))),
+          _mm_add_ps(_mm_mul_ps(c, _mm_loadu_ps(in.positiveZ(plane) + i)), d));
+      inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(sphere, zero),
+                                             _mm_cmpge_ps(box, zero)));
+    }
+    appendMask(_mm_movemask_ps(inside), i, visible);
+  }
+}
+
+__attribute__((target("avx2,fma"))) static void
+cullAvx2(const CullInput &in, size_t begin, size_t end,
+         std::vector<uint32_t> &visible) {
+  const __m256 zero = _mm256_setzero_ps();
+  for (size_t i = begin; i < end; i += 8) {
+    __m256 cx = _mm256_loadu_ps(in.centerX + i);
+    __m256 cy = _mm256_loadu_ps(in.centerY + i);
+    __m256 cz = _mm256_loadu_ps(in.centerZ + i);
+    __m256 r = _mm256_loadu_ps(in.radius + i);
+    __m256 inside = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+
+    for (const auto &plane : in.frustum->planes) {
+      __m256 a = _mm256_set1_ps(plane.x);
+      __m256 b = _mm256_set1_ps(plane.y);
+      __m256 c = _mm256_set1_ps(plane.z);
+      __m256 d = _mm256_set1_ps(plane.w);
+
+      __m256 sphere = _mm256_fmadd_ps(
+          a, cx,
+          _mm256_fmadd_ps(b, cy, _mm256_fmadd_ps(c, cz, _mm256_add_ps(d, r))));
+      __m256 box = _mm256_fmadd_ps(
+          a, _mm256_loadu_ps(in.positiveX(plane) + i),
+          _mm256_fmadd_ps(
+              b, _mm256_loadu_ps(in.positiveY(plane) + i),
+              _mm256_fmadd_ps(c, _mm256_loadu_ps(in.positiveZ(plane) + i), d)));
+      inside = _mm256_and_ps(
+          inside, _mm256_and_ps(_mm256_cmp_ps(sphere, zero, _CMP_GE_OQ),
+                                _mm256_cmp_ps(box, zero, _CMP_GE_OQ)));
+    }
+    appendMask(_mm256_movemask_ps(inside), i, visible);
+  }
+}
+
+__attribute__((target("avx512f"))) static void
+cullAvx512(const CullInput &in, size_t begin, size_t end,
+           std::vector<uint32_t> &visible) {
+  const __m512 zero = _mm512_setzero_ps();
+  for (size_t i = begin; i < end; i += 16) {
+    __m512 cx = _mm512_loadu_ps(in.centerX + i);
+    __m512 cy = _mm512_loadu_ps(in.centerY + i);
+    __m512 cz = _mm512_loadu_ps(in.centerZ + i);
+    __m512 r = _mm512_loadu_ps(in.radius + i);
+    __mmask16 inside = 0xffff;
+
+    for (const auto &plane : in.frustum->planes) {
+      __m512 a = _mm512_set1_ps(plane.x);
+      __m512 b = _mm512_set1_ps(plane.y);
+      __m512 c = _mm512_set1_ps(plane.z);
+      __m512 d = _mm512_set1_ps(plane.w);
+
+      __m512 sphere = _mm512_fmadd_ps(
+          a, cx,
+          _mm512_fmadd_ps(b, cy, _mm512_fmadd_ps(c, cz, _mm512_add_ps(d, r))));
+      __m512 box = _mm512_fmadd_ps(
+          a, _mm512_loadu_ps(in.positiveX(plane) + i),
+          _mm512_fmadd_ps(
+              b, _mm512_loadu_ps(in.positiveY(plane) + i),
+              _mm512_fmadd_ps(c, _mm512_loadu_ps(in.positiveZ(plane) + i), d)));
+      inside = _mm512_mask_cmp_ps_mask(inside, sphere, zero, _CMP_GE_OQ);
+      inside = _mm512_mask_cmp_ps_mask(inside, box, zero, _CMP_GE_OQ);
+    }
+    appendMask(inside, i, visible);
+  }
+}
+#endif
+
+using CullKernel = void (*)(const CullInput &, size_t, size_t,
+                            std::vector<uint32_t> &);
+
+static CullKernel selectCullKernel() {
+#if defined(TOFFOO_X86)
+  if (__builtin_cpu_supports("avx512f")) {
+    return cullAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return cullAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return cullSse;
+  }
+#endif
+  return cullScalar;
+}
+
+FrustumCuller::FrustumCuller(std::shared_ptr<ThreadPool> threadPool)
+    : threadPool(threadPool) {}
+
+void FrustumCuller::cull(BoundingVolumes &volumes, const Frustum &frustum,
+                         std::vector<uint32_t> &visible) {
+  static const CullKernel kernel = selectCullKernel();
+  // Below this a chunk costs less than handing it to a worker
+  const size_t minChunkSize = 4096;
+
+  CullInput in{volumes.centerX.data(), volumes.centerY.data(),
+               volumes.centerZ.data(), volumes.radius.data(),
+               volumes.minX.data(),    volumes.minY.data(),
+               volumes.minZ.data(),    volumes.maxX.data(),
+               volumes.maxY.data(),    volumes.maxZ.data(),
+               &frustum};
+  size_t padded = volumes.radius.size();
+
+  chunkVisible.resize(threadPool->size() + 1);
+
+  // Chunks start on a multiple of 16 so every kernel sees whole blocks. The
+  // first one runs on the calling thread and appends to visible directly.
+  size_t chunks = threadPool->parallelFor(
+      padded, minChunkSize,
+      [&](size_t chunk, size_t begin, size_t end) {
+        auto &out = chunk == 0 ? visible : chunkVisible[chunk];
+        out.clear();
+        kernel(in, begin, end, out);
+      },
+      16);
+
+  for (size_t c = 1; c < chunks; c++) {
+    visible.insert(visible.end(), chunkVisible[c].begin(),
+                   chunkVisible[c].end());
+  }
+}
+
+std::shared_ptr<FrustumCuller>
+createFrustumCuller(std::shared_ptr<ThreadPool> threadPool) {
+  return std::make_shared<FrustumCuller>(threadPool);
+}
+} // namespace toffoo::core
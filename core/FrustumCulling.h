@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+
+namespace toffoo::core {
+class ThreadPool;
+
+// Planes (a, b, c, d) facing inwards, a point is inside where
+// a * x + b * y + c * z + d >= 0 for all of them. The xyz part is normalized.
+struct Frustum {
+  glm::vec4 planes[6];
+
+  // Planes in the space viewProj transforms from, e.g. world space for
+  // proj * view. The near plane is the one of the OpenGL depth range, which
+  // is conservative for a [0, 1] range as well.
+  static Frustum fromMatrix(const glm::mat4 &viewProj);
+};
+
+// Bounding sphere and box of each object in structure of arrays layout, padded
+// to a multiple of 16 so the SIMD kernels never need a remainder loop
+class BoundingVolumes {
+private:
+  size_t count = 0;
+
+  std::vector<float> centerX, centerY, centerZ, radius;
+  std::vector<float> minX, minY, minZ;
+  std::vector<float> maxX, maxY, maxZ;
+
+public:
+  // Volumes that have not been set are never visible
+  void resize(size_t count);
+
+  size_t size();
+
+  void set(size_t idx, const glm::vec3 &center, float radius,
+           const glm::vec3 &boxMin, const glm::vec3 &boxMax);
+
+  // Bounds of the box [boxMin, boxMax] placed by transform, e.g. the bounds of
+  // a mesh under its model matrix
+  void set(size_t idx, const glm::mat4 &transform, const glm::vec3 &boxMin,
+           const glm::vec3 &boxMax);
+
+  friend class FrustumCuller;
+};
+
+// Tests 16, 8 or 4 objects at once with AVX-512, AVX2 or SSE, whichever the
+// CPU supports. Large sets are split across the thread pool.
+class FrustumCuller {
+private:
+  std::shared_ptr<ThreadPool> threadPool;
+
+  std::vector<std::vector<uint32_t>> chunkVisible;
+
+public:
+  FrustumCuller(std::shared_ptr<ThreadPool> threadPool);
+
+  // Replaces visible with the indices of the objects whose sphere and box both
+  // intersect the frustum, in increasing order. Blocks until the workers are
+  // done, so it must not be called from a task of the same pool. Chunks queue
+  // behind the texture decodes of a TextureStreamer sharing the pool, so a long
+  // decode delays the cull and the frame waiting on it.
+  void cull(BoundingVolumes &volumes, const Frustum &frustum,
+            std::vector<uint32_t> &visible);
+};
+
+std::shared_ptr<FrustumCuller>
+createFrustumCuller(std::shared_ptr<ThreadPool> threadPool);
+} // namespace toffoo::core
@@ -0,0 +1,295 @@
+#include "Json.h"
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace toffoo::core {
+class JsonParser {
+private:
+  // Arrays and objects recurse, deeper documents would exhaust the stack
+  static const size_t maxDepth = 512;
+
+  std::string_view text;
+  size_t pos = 0;
+  size_t depth = 0;
+
+  [[noreturn]] void fail(const char *message) {
+    throw std::runtime_error("invalid JSON at offset " + std::to_string(pos) +
+                             ": " + message + "!");
+  }
+
+  void skipWhitespace() {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' ||
+                                 text[pos] == '\n' || text[pos] == '\r')) {
+      pos++;
+    }
+  }
+
+  bool consume(char c) {
+    skipWhitespace();
+    if (pos < text.size() && text[pos] == c) {
+      pos++;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c) {
+    if (!consume(c)) {
+      fail("unexpected character");
+    }
+  }
+
+  bool consumeLiteral(std::string_view literal) {
+    if (text.substr(pos, literal.size()) == literal) {
+      pos += literal.size();
+      return true;
+    }
+    return false;
+  }
+
+  static void appendUtf8(std::string &out, uint32_t codepoint) {
+    if (codepoint < 0x80) {
+      out += (char)codepoint;
+    } else if (codepoint < 0x800) {
+      out += (char)(0xC0 | (codepoint >> 6));
+      out += (char)(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+      out += (char)(0xE0 | (codepoint >> 12));
+      out += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+      out += (char)(0x80 | (codepoint & 0x3F));
+    } else {
+      out += (char)(0xF0 | (codepoint >> 18));
+      out += (char)(0x80 | ((codepoint >> 12) & 0x3F));
+      out += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+      out += (char)(0x80 | (codepoint & 0x3F));
+    }
+  }
+
+  uint32_t parseHex4() {
+    if (pos + 4 > text.size()) {
+      fail("truncated escape");
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+      char c = text[pos++];
+      value <<= 4;
+      if (c >= '0' && c <= '9') {
+        value |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        value |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        value |= c - 'A' + 10;
+      } else {
+        fail("invalid escape");
+      }
+    }
+    return value;
+  }
+
+  std::string parseString() {
+    expect('"');
+    std::string out;
+    while (true) {
+      if (pos >= text.size()) {
+        fail("unterminated string");
+      }
+      char c = text[pos++];
+      if (c == '"') {
+        return out;
+      }
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+
+      if (pos >= text.size()) {
+        fail("unterminated string");
+      }
+      switch (text[pos++]) {
+      case '"':
+        out += '"';
+        break;
+      case '\\':
+        out += '\\';
+        break;
+      case '/':
+        out += '/';
+        break;
+      case 'b':
+        out += '\b';
+        break;
+      case 'f':
+        out += '\f';
+        break;
+      case 'n':
+        out += '\n';
+        break;
+      case 'r':
+        out += '\r';
+        break;
+      case 't':
+        out += '\t';
+        break;
+      case 'u': {
+        uint32_t codepoint = parseHex4();
+        // Characters outside the BMP come as a surrogate pair
+        if (codepoint >= 0xDC00 && codepoint < 0xE000) {
+          fail("unpaired surrogate");
+        }
+        if (codepoint >= 0xD800 && codepoint < 0xDC00) {
+          if (!consumeLiteral("\\u")) {
+            fail("unpaired surrogate");
+          }
+          uint32_t low = parseHex4();
+          if (low < 0xDC00 || low >= 0xE000) {
+            fail("unpaired surrogate");
+          }
+          codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+        }
+        appendUtf8(out, codepoint);
+        break;
+      }
+      default:
+        fail("invalid escape");
+      }
+    }
+  }
+
+  Json parseValue() {
+    skipWhitespace();
+    if (pos >= text.size()) {
+      fail("unexpected end");
+    }
+
+    Json value;
+    char c = text[pos];
+    if ((c == '{' || c == '[') && depth == maxDepth) {
+      fail("nesting too deep");
+    }
+    if (c == '{') {
+      depth++;
+      pos++;
+      value.type = Json::Type::Object;
+      if (!consume('}')) {
+        do {
+          skipWhitespace();
+          std::string key = parseString();
+          expect(':');
+          value.object.emplace_back(std::move(key), parseValue());
+        } while (consume(','));
+        expect('}');
+      }
+      depth--;
+    } else if (c == '[') {
+      depth++;
+      pos++;
+      value.type = Json::Type::Array;
+      if (!consume(']')) {
+        do {
+          value.array.push_back(parseValue());
+        } while (consume(','));
+        expect(']');
+      }
+      depth--;
+    } else if (c == '"') {
+      value.type = Json::Type::String;
+      value.string = parseString();
+    } else if (consumeLiteral("true")) {
+      value.type = Json::Type::Bool;
+      value.boolean = true;
+    } else if (consumeLiteral("false")) {
+      value.type = Json::Type::Bool;
+    } else if (consumeLiteral("null")) {
+      value.type = Json::Type::Null;
+    } else {
+      // strtod needs a terminated string, numbers are short
+      size_t end = pos;
+      while (end < text.size() &&
+             std::string_view("+-0123456789.eE").find(text[end]) !=
+                 std::string_view::npos) {
+        end++;
+      }
+      std::string token(text.substr(pos, end - pos));
+      char *parsed = nullptr;
+      value.number = std::strtod(token.c_str(), &parsed);
+      if (token.empty() || parsed != token.c_str() + token.size()) {
+        fail("invalid value");
+      }
+      value.type = Json::Type::Number;
+      pos = end;
+    }
+    return value;
+  }
+
+public:
+  JsonParser(std::string_view text) : text(text) {}
+
+  Json parse() {
+    Json value = parseValue();
+    skipWhitespace();
+    if (pos != text.size()) {
+      fail("trailing characters");
+    }
+    return value;
+  }
+};
+
+Json Json::parse(std::string_view text) { return JsonParser(text).parse(); }
+
+Json::Type Json::getType() const { return type; }
+
+bool Json::has(const std::string &key) const {
+  for (auto &[name, value] : object) {
+    if (name == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const Json &Json::operator[](const std::string &key) const {
+  for (auto &[name, value] : object) {
+    if (name == key) {
+      return value;
+    }
+  }
+  throw std::out_of_range("missing JSON member " + key + "!");
+}
+
+const Json &Json::operator[](size_t index) const {
+  if (index >= array.size()) {
+    throw std::out_of_range("JSON array index out of range!");
+  }
+  return array[index];
+}
+
+size_t Json::size() const {
+  return type == Type::Array ? array.size() : object.size();
+}
+
+bool Json::asBool() const {
+  if (type != Type::Bool) {
+    throw std::runtime_error("JSON value is not a bool!");
+  }
+  return boolean;
+}
+
+double Json::asNumber() const {
+  if (type != Type::Number) {
+    throw std::runtime_error("JSON value is not a number!");
+  }
+  return number;
+}
+
+const std::string &Json::asString() const {
+  if (type != Type::String) {
+    throw std::runtime_error("JSON value is not a string!");
+  }
+  return string;
+}
+
+double Json::get(const std::string &key, double fallback) const {
+  return has(key) ? (*this)[key].asNumber() : fallback;
+}
+} // namespace toffoo::core
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace toffoo::core {
+// Just enough JSON for asset formats such as glTF, the whole document is
+// parsed into a tree of values
+class Json {
+public:
+  enum class Type { Null, Bool, Number, String, Array, Object };
+
+private:
+  Type type = Type::Null;
+  bool boolean = false;
+  double number = 0.0;
+  std::string string;
+  std::vector<Json> array;
+  // Keeps document order, objects in asset files are small
+  std::vector<std::pair<std::string, Json>> object;
+
+  friend class JsonParser;
+
+public:
+  static Json parse(std::string_view text);
+
+  Type getType() const;
+
+  bool has(const std::string &key) const;
+
+  // Both throw when the key or index does not exist
+  const Json &operator[](const std::string &key) const;
+  const Json &operator[](size_t index) const;
+
+  // Element count of arrays and objects, 0 otherwise
+  size_t size() const;
+
+  bool asBool() const;
+  double asNumber() const;
+  const std::string &asString() const;
+
+  // Value of an optional number member
+  double get(const std::string &key, double fallback) const;
+};
+} // namespace toffoo::core
@@ -0,0 +1,22 @@
+#include "LodSelection.h"
+#include <algorithm>
+
+namespace toffoo::core {
+uint32_t LodSelector::select(std::span<const float> errors, float scale,
+                             float distance, uint32_t current) const {
+  if (errors.empty() || distance <= 0.0f) {
+    return 0;
+  }
+
+  float pixelsPerUnit = scale * projectionScale / distance;
+  uint32_t level = std::min<uint32_t>(current, errors.size() - 1);
+  while (level > 0 && errors[level] * pixelsPerUnit > threshold) {
+    level--;
+  }
+  while (level + 1 < errors.size() &&
+         errors[level + 1] * pixelsPerUnit < threshold * (1.0f - hysteresis)) {
+    level++;
+  }
+  return level;
+}
+} // namespace toffoo::core
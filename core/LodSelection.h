@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace toffoo::core {
+// Picks levels of detail by how large their error appears on screen. errors
+// are the deviations of the levels in object space, increasing from 0 for the
+// full mesh (asset::MeshLod::error). shaders/cull.comp does the same on the
+// GPU.
+struct LodSelector {
+  // Pixels per unit at distance 1, |proj[1][1]| * viewportHeight / 2
+  float projectionScale;
+  // Largest error in pixels a level may show
+  float threshold = 1.0f;
+  // A coarser level is only taken once its error is this fraction below the
+  // threshold, so objects close to a switch do not flip every frame
+  float hysteresis = 0.25f;
+
+  // distance is from the camera to the nearest point of the bounds, scale the
+  // largest scale of the object transform. current is the level of the
+  // previous frame.
+  uint32_t select(std::span<const float> errors, float scale, float distance,
+                  uint32_t current) const;
+};
+} // namespace toffoo::core
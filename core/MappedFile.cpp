@@ -0,0 +1,57 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace toffoo::core {
+MappedFile::MappedFile(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("failed to open " + path + "!");
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    close(fd);
+    throw std::runtime_error("failed to stat " + path + "!");
+  }
+  fileSize = info.st_size;
+
+  if (fileSize > 0) {
+    void *ptr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error("failed to map " + path + "!");
+    }
+    mapping = static_cast<const char *>(ptr);
+    // Assets are read front to back, let the kernel read ahead aggressively
+    madvise(ptr, fileSize, MADV_SEQUENTIAL);
+  }
+
+  // The mapping keeps its own reference to the file
+  close(fd);
+}
+
+const char *MappedFile::data() { return mapping; }
+
+size_t MappedFile::size() { return fileSize; }
+
+std::span<const char> MappedFile::get(size_t offset, size_t size) {
+  if (offset > fileSize || size > fileSize - offset) {
+    throw std::out_of_range("range is outside of the mapped file!");
+  }
+  return {mapping + offset, size};
+}
+
+MappedFile::~MappedFile() {
+  if (mapping) {
+    munmap(const_cast<char *>(mapping), fileSize);
+  }
+}
+
+std::shared_ptr<MappedFile> createMappedFile(const std::string &path) {
+  return std::make_shared<MappedFile>(path);
+}
+} // namespace toffoo::core
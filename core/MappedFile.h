@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+
+namespace toffoo::core {
+// Read-only view of a whole file through mmap, pages are faulted in by the
+// kernel on first access instead of being copied into a heap buffer
+class MappedFile {
+private:
+  const char *mapping = nullptr;
+  size_t fileSize = 0;
+
+public:
+  MappedFile(const std::string &path);
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data();
+  size_t size();
+
+  // Bounds checked sub-range of the file
+  std::span<const char> get(size_t offset, size_t size);
+
+  ~MappedFile();
+};
+
+std::shared_ptr<MappedFile> createMappedFile(const std::string &path);
+} // namespace toffoo::core
@@ -0,0 +1,120 @@
+#include "SceneGraph.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace toffoo::core {
+SceneGraph::SceneGraph(std::shared_ptr<ThreadPool> threadPool)
+    : threadPool(threadPool) {}
+
+uint32_t SceneGraph::addNode(uint32_t parent, const glm::mat4 &local) {
+  uint32_t parentSlot = noParent;
+  uint32_t depth = 0;
+  if (parent != noParent) {
+    if (parent >= slots.size()) {
+      throw std::out_of_range("unknown parent node!");
+    }
+    parentSlot = slots[parent];
+    depth = depths[parentSlot] + 1;
+  }
+  if (depth + 1 == levelOffsets.size()) {
+    levelOffsets.push_back(levelOffsets.back());
+  }
+
+  // Appended to its level, every deeper node moves one slot back. The parent
+  // is in an earlier level and keeps its slot.
+  uint32_t slot = levelOffsets[depth + 1];
+  for (auto &p : parents) {
+    if (p != noParent && p >= slot) {
+      p++;
+    }
+  }
+  for (auto &s : slots) {
+    if (s >= slot) {
+      s++;
+    }
+  }
+  for (size_t level = depth + 1; level < levelOffsets.size(); level++) {
+    levelOffsets[level]++;
+  }
+
+  parents.insert(parents.begin() + slot, parentSlot);
+  depths.insert(depths.begin() + slot, depth);
+  locals.insert(locals.begin() + slot, local);
+  worlds.insert(worlds.begin() + slot, local);
+  dirty.insert(dirty.begin() + slot, 1);
+  firstDirtyLevel = std::min<size_t>(firstDirtyLevel, depth);
+
+  slots.push_back(slot);
+  return slots.size() - 1;
+}
+
+size_t SceneGraph::size() { return slots.size(); }
+
+void SceneGraph::setLocal(uint32_t node, const glm::mat4 &local) {
+  uint32_t slot = slots.at(node);
+  locals[slot] = local;
+  dirty[slot] = 1;
+  firstDirtyLevel = std::min<size_t>(firstDirtyLevel, depths[slot]);
+}
+
+const glm::mat4 &SceneGraph::getLocal(uint32_t node) {
+  return locals[slots.at(node)];
+}
+
+const glm::mat4 &SceneGraph::getWorld(uint32_t node) {
+  return worlds[slots.at(node)];
+}
+
+void SceneGraph::updateRange(size_t begin, size_t end) {
+  // Parents are in the previous level, which is complete
+  for (size_t i = begin; i < end; i++) {
+    uint32_t parent = parents[i];
+    if (parent == noParent) {
+      if (dirty[i]) {
+        worlds[i] = locals[i];
+      }
+    } else if (dirty[i] || dirty[parent]) {
+      dirty[i] = 1;
+      worlds[i] = worlds[parent] * locals[i];
+    }
+  }
+}
+
+void SceneGraph::update() {
+  // Below this a chunk costs less than handing it to a worker
+  const size_t minChunkSize = 1024;
+
+  size_t levelCount = levelOffsets.size() - 1;
+  for (size_t level = firstDirtyLevel; level < levelCount; level++) {
+    size_t begin = levelOffsets[level];
+    size_t count = levelOffsets[level + 1] - begin;
+
+    threadPool->parallelFor(count, minChunkSize,
+                            [&](size_t, size_t first, size_t last) {
+                              updateRange(begin + first, begin + last);
+                            });
+  }
+
+  // Flags of a level are read by the next one, so they are only cleared once
+  // all levels are done
+  if (firstDirtyLevel < levelCount) {
+    std::fill(dirty.begin() + levelOffsets[firstDirtyLevel], dirty.end(), 0);
+  }
+  firstDirtyLevel = levelCount;
+}
+
+void SceneGraph::copyWorlds(std::span<const uint32_t> nodes, void *dst,
+                            size_t stride) {
+  auto *out = static_cast<char *>(dst);
+  for (size_t i = 0; i < nodes.size(); i++) {
+    memcpy(out + i * stride, &worlds[slots.at(nodes[i])], sizeof(glm::mat4));
+  }
+}
+
+std::shared_ptr<SceneGraph>
+createSceneGraph(std::shared_ptr<ThreadPool> threadPool) {
+  return std::make_shared<SceneGraph>(threadPool);
+}
+} // namespace toffoo::core
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace toffoo::core {
+class ThreadPool;
+
+// Transform hierarchy in structure of arrays layout. Nodes are stored sorted
+// by depth, so every level is a contiguous range that only reads the levels
+// before it and can be split across the thread pool. Nodes are referred to by
+// the stable ids addNode returns, their storage slots move as nodes are added.
+class SceneGraph {
+private:
+  std::shared_ptr<ThreadPool> threadPool;
+
+  // Indexed by slot
+  std::vector<uint32_t> parents;
+  std::vector<uint32_t> depths;
+  std::vector<glm::mat4> locals;
+  std::vector<glm::mat4> worlds;
+  // Bytes rather than bits so workers can write neighbouring flags
+  std::vector<uint8_t> dirty;
+
+  // Slot of each node id
+  std::vector<uint32_t> slots;
+  // First slot of each depth followed by the node count
+  std::vector<uint32_t> levelOffsets = {0};
+  // Levels before this one have no dirty nodes
+  size_t firstDirtyLevel = 0;
+
+  void updateRange(size_t begin, size_t end);
+
+public:
+  static const uint32_t noParent = UINT32_MAX;
+
+  SceneGraph(std::shared_ptr<ThreadPool> threadPool);
+
+  // Costs linear time in the node count, meant for building the scene rather
+  // than for every frame
+  uint32_t addNode(uint32_t parent = noParent,
+                   const glm::mat4 &local = glm::mat4(1.0f));
+
+  size_t size();
+
+  // Marks the node and its subtree for the next update
+  void setLocal(uint32_t node, const glm::mat4 &local);
+  const glm::mat4 &getLocal(uint32_t node);
+
+  // As of the last update
+  const glm::mat4 &getWorld(uint32_t node);
+
+  // Recomputes the world transforms of the changed subtrees one level at a
+  // time. Blocks until the workers are done, so it must not be called from a
+  // task of the same pool. When that pool also decodes for an
+  // asset::TextureStreamer, each level waits for the decodes queued ahead of
+  // it and a long decode stalls the frame.
+  void update();
+
+  // Writes the world transform of nodes[i] to dst + i * stride, e.g. straight
+  // into a mapped instance or uniform buffer
+  void copyWorlds(std::span<const uint32_t> nodes, void *dst, size_t stride);
+};
+
+std::shared_ptr<SceneGraph>
+createSceneGraph(std::shared_ptr<ThreadPool> threadPool);
+} // namespace toffoo::core
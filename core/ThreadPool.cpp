@@ -0,0 +1,78 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <latch>
+
+namespace toffoo::core {
+ThreadPool::ThreadPool(size_t threadCount) {
+  if (threadCount == 0) {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (size_t i = 0; i < threadCount; i++) {
+    workers.emplace_back(&ThreadPool::run, this);
+  }
+}
+
+void ThreadPool::run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+      if (tasks.empty()) {
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+    task();
+  }
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push(std::move(task));
+  }
+  condition.notify_one();
+}
+
+size_t ThreadPool::size() { return workers.size(); }
+
+size_t ThreadPool::parallelFor(
+    size_t count, size_t minChunkSize,
+    const std::function<void(size_t chunk, size_t begin, size_t end)> &fn,
+    size_t granularity) {
+  size_t chunks = std::clamp<size_t>(count / minChunkSize, 1, size() + 1);
+  size_t chunkSize = (count + chunks - 1) / chunks;
+  chunkSize = (chunkSize + granularity - 1) / granularity * granularity;
+
+  std::latch done(chunks - 1);
+  for (size_t c = 1; c < chunks; c++) {
+    enqueue([&, c]() {
+      fn(c, std::min(c * chunkSize, count),
+         std::min((c + 1) * chunkSize, count));
+      done.count_down();
+    });
+  }
+  fn(0, 0, std::min(chunkSize, count));
+  done.wait();
+  return chunks;
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  condition.notify_all();
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+std::shared_ptr<ThreadPool> createThreadPool(size_t threadCount) {
+  return std::make_shared<ThreadPool>(threadCount);
+}
+} // namespace toffoo::core
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace toffoo::core {
+class ThreadPool {
+private:
+  std::vector<std::thread> workers;
+
+  std::queue<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool stopping = false;
+
+  void run();
+
+public:
+  // Zero threads means one per hardware thread
+  ThreadPool(size_t threadCount = 0);
+
+  void enqueue(std::function<void()> task);
+
+  size_t size();
+
+  // Splits [0, count) into at most size() + 1 chunks of at least minChunkSize
+  // items, rounded up to a multiple of granularity, and calls
+  // fn(chunk, begin, end) for each. The calling thread runs chunk 0 and then
+  // waits for the rest, which queue behind any tasks already enqueued, e.g.
+  // texture decodes. It must not be called from a task of this pool. Returns
+  // the number of chunks.
+  size_t parallelFor(
+      size_t count, size_t minChunkSize,
+      const std::function<void(size_t chunk, size_t begin, size_t end)> &fn,
+      size_t granularity = 1);
+
+  // Finishes the queued tasks before joining the workers
+  ~ThreadPool();
+};
+
+std::shared_ptr<ThreadPool> createThreadPool(size_t threadCount = 0);
+} // namespace toffoo::core
@@ -1,33 +1,57 @@
+#include "asset/Archive.h"
+#include "asset/Mesh.h"
+#include "asset/MeshOptimizer.h"
+#include "asset/MeshSimplifier.h"
+#include "asset/ResidencyManager.h"
+#include "asset/TextureLoader.h"
+#include "asset/TextureStreamer.h"
+#include "asset/VertexFormat.h"
+#include "core/FrustumCulling.h"
+#include "core/LodSelection.h"
+#include "core/SceneGraph.h"
+#include "core/ThreadPool.h"
 #include "vk/CommandBuffers.h"
 #include "vk/CommandPool.h"
+#include "vk/DescriptorBuffer.h"
 #include "vk/DescriptorSetPool.h"
 #include "vk/DescriptorSets.h"
 #include "vk/Device.h"
+#include "vk/DrawCuller.h"
 #include "vk/Framebuffer.h"
 #include "vk/Image.h"
 #include "vk/IndexBuffer.h"
+#include "vk/IndirectBuffer.h"
 #include "vk/Instance.h"
+#include "vk/MeshPool.h"
 #include "vk/Pipeline.h"
+#include "vk/PipelineLibrary.h"
 #include "vk/RenderPass.h"
+#include "vk/RingBuffer.h"
+#include "vk/SamplerCache.h"
 #include "vk/Semaphore.h"
 #include "vk/Shader.h"
 #include "vk/Surface.h"
 #include "vk/SwapChain.h"
 #include "vk/UniformBuffer.h"
 #include "vk/VertexBuffer.h"
+#include "vk/VertexLayout.h"
 #include "vk/WriteDescriptorSetWrapper.h"
 
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/projection.hpp>
 #include <glm/gtx/rotate_vector.hpp>
+#include <span>
+#include <string>
 #include <vector>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "thirdparty/stb_image.h"
-
 std::vector<const char *> getRequiredExtensions() {
   uint32_t glfwExtensionCount = 0;
   auto glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
@@ -38,41 +62,28 @@ std::vector<const char *> getRequiredExtensions() {
 }
 
 struct Vertex {
-  glm::vec2 pos;
+  glm::vec3 pos;
   glm::vec3 color;
   glm::vec2 texCoord;
+};
 
-  static VkVertexInputBindingDescription getBindingDescription() {
-    VkVertexInputBindingDescription bindingDescription{};
-    bindingDescription.binding = 0;
-    bindingDescription.stride = sizeof(Vertex);
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-    return bindingDescription;
-  }
-
-  static std::vector<VkVertexInputAttributeDescription>
-  getAttributeDescriptions() {
-    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(3);
-
-    attributeDescriptions[0].binding = 0;
-    attributeDescriptions[0].location = 0;
-    attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-    attributeDescriptions[0].offset = offsetof(Vertex, pos);
+using QuadLayout =
+    toffoo::vk::VertexLayout<Vertex, VK_VERTEX_ATTRIBUTE(Vertex, pos),
+                             VK_VERTEX_ATTRIBUTE(Vertex, color),
+                             VK_VERTEX_ATTRIBUTE(Vertex, texCoord)>;
 
-    attributeDescriptions[1].binding = 0;
-    attributeDescriptions[1].location = 1;
-    attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attributeDescriptions[1].offset = offsetof(Vertex, color);
+// Per instance stream at binding 1, locations 3-6
+struct Instance {
+  glm::mat4 transform;
+};
 
-    attributeDescriptions[2].binding = 0;
-    attributeDescriptions[2].location = 2;
-    attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-    attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
+using InstanceLayout =
+    toffoo::vk::VertexLayout<Instance,
+                             VK_VERTEX_ATTRIBUTE(Instance, transform)>;
 
-    return attributeDescriptions;
-  }
-};
+// The copies form a grid over [-1, 1] in the xy plane
+const uint32_t instanceGridSize = 32;
+const uint32_t instanceCount = instanceGridSize * instanceGridSize;
 
 struct UniformBufferObject {
   glm::mat4 model;
@@ -80,8 +91,10 @@ struct UniformBufferObject {
   glm::mat4 proj;
 };
 
-void updateUniformBuffer(std::shared_ptr<toffoo::vk::UniformBuffer> buffer,
-                         size_t width, size_t height) {
+UniformBufferObject
+updateUniformBuffer(std::shared_ptr<toffoo::vk::UniformBuffer> buffer,
+                    size_t width, size_t height,
+                    const glm::mat4 &meshTransform) {
   static auto startTime = std::chrono::high_resolution_clock::now();
 
   auto currentTime = std::chrono::high_resolution_clock::now();
@@ -91,7 +104,8 @@ void updateUniformBuffer(std::shared_ptr<toffoo::vk::UniformBuffer> buffer,
 
   UniformBufferObject ubo{};
   ubo.model = glm::rotate(glm::mat4(1.0f), time * glm::radians(90.0f),
-                          glm::vec3(0.0f, 0.0f, 1.0f));
+                          glm::vec3(0.0f, 0.0f, 1.0f)) *
+              meshTransform;
   ubo.view =
       glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f),
                   glm::vec3(0.0f, 0.0f, 1.0f));
@@ -99,6 +113,31 @@ void updateUniformBuffer(std::shared_ptr<toffoo::vk::UniformBuffer> buffer,
       glm::perspective(glm::radians(45.0f), width / (float)height, 0.1f, 10.0f);
   ubo.proj[1][1] *= -1;
   buffer->fill_from(&ubo);
+  return ubo;
+}
+
+void updateInstances(toffoo::core::SceneGraph &sceneGraph,
+                     const std::vector<uint32_t> &instanceNodes) {
+  static auto startTime = std::chrono::high_resolution_clock::now();
+
+  auto currentTime = std::chrono::high_resolution_clock::now();
+  float time = std::chrono::duration<float, std::chrono::seconds::period>(
+                   currentTime - startTime)
+                   .count();
+
+  float cellSize = 2.0f / instanceGridSize;
+  for (uint32_t y = 0; y < instanceGridSize; y++) {
+    for (uint32_t x = 0; x < instanceGridSize; x++) {
+      // A wave running diagonally through the grid
+      glm::vec3 position(-1.0f + (x + 0.5f) * cellSize,
+                         -1.0f + (y + 0.5f) * cellSize,
+                         0.1f * std::sin(time * 2.0f + (x + y) * 0.3f));
+      sceneGraph.setLocal(
+          instanceNodes[y * instanceGridSize + x],
+          glm::scale(glm::translate(glm::mat4(1.0f), position),
+                     glm::vec3(cellSize)));
+    }
+  }
 }
 
 int main() {
@@ -114,7 +153,12 @@ int main() {
 
   auto surface = toffoo::vk::createGlfwSurface(instance, window);
 
-  auto device = toffoo::vk::createDevice(instance, surface);
+  // TOFFOO_DESCRIPTOR_BUFFER selects VK_EXT_descriptor_buffer where the GPU
+  // has it, the picture is the same as with descriptor sets
+  auto descriptorBackend = std::getenv("TOFFOO_DESCRIPTOR_BUFFER")
+                               ? toffoo::vk::DescriptorBackend::Buffer
+                               : toffoo::vk::DescriptorBackend::Sets;
+  auto device = toffoo::vk::createDevice(instance, surface, descriptorBackend);
 
   int width, height;
   glfwGetFramebufferSize(window, &width, &height);
@@ -128,37 +172,160 @@ int main() {
 
   auto commandPool = toffoo::vk::createCommandPool(device);
 
-  auto commandBuffers = toffoo::vk::createCommandBuffers(device, commandPool,
-                                                         framebuffers.size());
-
-  const std::vector<Vertex> vertices = {
-      {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
-      {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
-      {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
-      {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f}}};
-
-  const std::vector<uint16_t> indices = {0, 1, 2, 2, 3, 0};
-
-  auto bindingDescription = Vertex::getBindingDescription();
-  auto attributeDescriptions = Vertex::getAttributeDescriptions();
-
-  auto vertexBuffer =
-      toffoo::vk::createVertexBuffer(device, sizeof(Vertex) * vertices.size());
+  std::shared_ptr<toffoo::vk::CommandBuffers> commandBuffers;
+
+  std::vector<Vertex> vertices = {
+      {{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {1.0f, 0.0f}},
+      {{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}},
+      {{0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 1.0f}},
+      {{-0.5f, 0.5f, 0.0f}, {1.0f, 1.0f, 1.0f}, {1.0f, 1.0f}}};
+
+  std::vector<uint32_t> indices = {0, 1, 2, 2, 3, 0};
+
+  auto bindingDescription = QuadLayout::getBindingDescription();
+  std::span<const char> vertexData(
+      reinterpret_cast<const char *>(vertices.data()),
+      sizeof(Vertex) * vertices.size());
+  const char *vertexShader = "vert.spv";
+  glm::mat4 meshTransform(1.0f);
+  glm::vec3 meshMin(-0.5f, -0.5f, 0.0f);
+  glm::vec3 meshMax(0.5f, 0.5f, 0.0f);
+
+  // A model next to the executable replaces the quad. It is stored in the
+  // compact asset::VertexFormat and colored by its normals.
+  toffoo::asset::QuantizedMesh model;
+  std::vector<VkVertexInputAttributeDescription> modelAttributes;
+  // Levels of detail of the model, the quad only has the full mesh
+  std::vector<std::vector<uint32_t>> lodIndices;
+  std::vector<float> lodErrors = {0.0f};
+  for (const char *candidate : {"model.glb", "model.gltf", "model.obj"}) {
+    if (!std::filesystem::exists(candidate)) {
+      continue;
+    }
+    auto mesh = toffoo::asset::loadMesh(candidate);
+    toffoo::asset::optimizeMesh(mesh);
+    auto lods = toffoo::asset::generateLods(mesh);
+    model = toffoo::asset::quantizeMesh(mesh, {});
+    // Errors are measured on the original positions, the culling works in
+    // the normalized ones
+    lodErrors.clear();
+    for (auto &lod : lods) {
+      lodIndices.push_back(std::move(lod.indices));
+      lodErrors.push_back(lod.error / model.positionScale);
+    }
+
+    bindingDescription = model.getBindingDescription(0);
+    modelAttributes = model.getAttributeDescriptions(0);
+    vertexData = model.vertices;
+    indices = lodIndices.front();
+    vertexShader = "mesh.spv";
+    // Positions are normalized to the unit cube
+    meshMin = glm::vec3(0.0f);
+    meshMax = glm::vec3(1.0f);
+    meshTransform =
+        glm::translate(glm::mat4(1.0f),
+                       glm::vec3(model.positionOffset[0],
+                                 model.positionOffset[1],
+                                 model.positionOffset[2])) *
+        glm::scale(glm::mat4(1.0f), glm::vec3(model.positionScale));
+    break;
+  }
+  if (lodIndices.empty()) {
+    lodIndices.push_back(indices);
+  }
+  uint32_t lodCount = lodIndices.size();
+
+  // Meshes share one vertex and index buffer, indices are 8, 16 or 32-bit,
+  // whichever is the smallest for the vertex count. The levels of detail
+  // follow each other in the index buffer.
+  uint32_t vertexCount = vertexData.size() / bindingDescription.stride;
+  size_t lodIndexCount = 0;
+  for (const auto &lod : lodIndices) {
+    lodIndexCount += lod.size();
+  }
+  auto meshPool = toffoo::vk::createMeshPool(
+      device, bindingDescription.stride, vertexCount, lodIndexCount,
+      toffoo::vk::IndexBuffer::getCompactIndexType(*device, vertexCount));
+  auto meshLods = meshPool->add(vertexData, lodIndices);
+
+  // Instances outside of the view are culled on the GPU when each of them can
+  // get its own draw, which also picks their level of detail
+  glm::vec3 meshCenter = (meshMin + meshMax) * 0.5f;
+  float meshRadius = glm::length(meshMax - meshMin) * 0.5f;
+  std::shared_ptr<toffoo::vk::DrawCuller> culler;
+  if (device->getFeatures().drawIndirectFirstInstance &&
+      device->getDescriptorBackend() == toffoo::vk::DescriptorBackend::Sets) {
+    culler = toffoo::vk::createDrawCuller(device, instanceCount, lodCount,
+                                          framebuffers.size());
+    std::vector<toffoo::vk::DrawLod> drawLods;
+    for (uint32_t level = 0; level < lodCount; level++) {
+      drawLods.push_back({.firstIndex = meshLods[level].firstIndex,
+                          .indexCount = meshLods[level].indexCount,
+                          .error = lodErrors[level]});
+    }
+    culler->setObjects(
+        std::vector<toffoo::vk::DrawObject>(
+            instanceCount, {.boundingSphere = glm::vec4(meshCenter, meshRadius),
+                            .firstLod = 0,
+                            .lodCount = lodCount,
+                            .vertexOffset = meshLods.front().vertexOffset}),
+        drawLods);
+    culler->setLodSelection(swapchain->getExtent().height);
+  }
 
-  auto indexBuffer =
-      toffoo::vk::createIndexBuffer(device, sizeof(uint16_t) * indices.size());
+  // Otherwise they are culled on the CPU and the visible ones are drawn with
+  // one instanced command per level of detail, see the frame loop. Without
+  // firstInstance every draw starts at the first instance, so all of them use
+  // the full mesh.
+  uint32_t cpuLodCount =
+      device->getFeatures().drawIndirectFirstInstance ? lodCount : 1;
+  auto indirectBuffer = toffoo::vk::createIndirectBuffer(device, cpuLodCount);
+  std::vector<VkDrawIndexedIndirectCommand> lodCommands;
+  for (uint32_t level = 0; level < cpuLodCount; level++) {
+    lodCommands.push_back(meshLods[level].getDrawCommand(0));
+  }
+  indirectBuffer->write(lodCommands);
 
-  vertexBuffer->fill_from((void *)vertices.data());
-  indexBuffer->fill_from((void *)indices.data());
+  auto pipelineLibraries = toffoo::vk::createPipelineLibraryCache(device);
 
   toffoo::vk::GraphicsPipelineBuilder pipelineBuilder(device, renderPass);
+  pipelineBuilder.usePipelineLibraryCache(pipelineLibraries);
 
-  pipelineBuilder.addVertexShader(toffoo::vk::createShader(device, "vert.spv"));
-  pipelineBuilder.addFragmentShader(
-      toffoo::vk::createShader(device, "frag.spv"));
-
-  pipelineBuilder.addVertexInputState(attributeDescriptions,
-                                      bindingDescription);
+  // Cooked builds ship the shaders in assets.pak, loose files are the fallback
+  std::shared_ptr<toffoo::asset::Archive> archive;
+  if (std::filesystem::exists("assets.pak")) {
+    archive = toffoo::asset::openArchive("assets.pak");
+  }
+  auto loadShader = [&](const char *name) {
+    return archive && archive->contains(name)
+               ? toffoo::asset::createShader(device, *archive, name)
+               : toffoo::vk::createShader(device, name);
+  };
+
+  pipelineBuilder.addVertexShader(loadShader(vertexShader));
+  pipelineBuilder.addFragmentShader(loadShader("frag.spv"));
+
+  // Vertices at binding 0, instance transforms at binding 1. The model format
+  // is only known once it is loaded.
+  toffoo::vk::VertexLayoutBinding<InstanceLayout> instanceBinding{
+      .binding = 1,
+      .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
+      .firstLocation = 3};
+  if (modelAttributes.empty()) {
+    pipelineBuilder.addVertexInputState(
+        toffoo::vk::VertexLayoutBinding<QuadLayout>{}, instanceBinding);
+  } else {
+    auto attributes = modelAttributes;
+    for (const auto &attribute : InstanceLayout::getAttributeDescriptions(
+             instanceBinding.binding, instanceBinding.firstLocation)) {
+      attributes.push_back(attribute);
+    }
+    VkVertexInputBindingDescription bindings[] = {
+        bindingDescription,
+        InstanceLayout::getBindingDescription(instanceBinding.binding,
+                                              instanceBinding.inputRate)};
+    pipelineBuilder.addVertexInputState(attributes, bindings);
+  }
   pipelineBuilder.addInputAssemblyState();
   pipelineBuilder.addViewportState(swapchain, width, height);
   pipelineBuilder.addRasterizationState();
@@ -168,7 +335,8 @@ int main() {
   pipelineBuilder.addDescritorSetLayoutBinding(
       toffoo::vk::UniformBuffer::getDescriptorSetLayoutBinding(0));
   pipelineBuilder.addDescritorSetLayoutBinding(
-      toffoo::vk::Image::getDescriptorSetLayoutBinding(1));
+      toffoo::vk::Image::getDescriptorSetLayoutBinding(
+          1, &device->getSamplerCache().get()));
 
   auto pipeline = pipelineBuilder.build();
 
@@ -179,44 +347,175 @@ int main() {
     b = toffoo::vk::createUniformBuffer(device, sizeof(UniformBufferObject));
   }
 
-  auto descriptorPool =
-      toffoo::vk::createDescriptorSetPool(device, framebuffers.size());
-
-  auto descriptorSets = toffoo::vk::createDescriptorSets(
-      device, descriptorPool, pipeline, framebuffers.size());
-
-  int texWidth, texHeight, texChannels;
-  auto texImg = stbi_load("texture.jpg", &texWidth, &texHeight, &texChannels,
-                          STBI_rgb_alpha);
+  // Descriptor buffers replace the pool and the sets when the device uses them
+  std::shared_ptr<toffoo::vk::DescriptorSets> descriptorSets;
+  std::shared_ptr<toffoo::vk::DescriptorBuffer> descriptorBuffer;
+  if (device->getDescriptorBackend() == toffoo::vk::DescriptorBackend::Buffer) {
+    descriptorBuffer = toffoo::vk::createDescriptorBuffer(device, pipeline,
+                                                          framebuffers.size());
+  } else {
+    auto descriptorPool =
+        toffoo::vk::createDescriptorSetPool(device, framebuffers.size());
+    descriptorSets = toffoo::vk::createDescriptorSets(
+        device, descriptorPool, pipeline, framebuffers.size());
+  }
 
-  auto image = toffoo::vk::Image::create(device, commandPool, texImg, texWidth,
-                                         texHeight);
+  auto threadPool = toffoo::core::createThreadPool();
+  auto textureStreamer =
+      toffoo::asset::createTextureStreamer(device, commandPool, threadPool);
+
+  // The copies are children of one grid node, their world transforms form
+  // the instance stream
+  auto sceneGraph = toffoo::core::createSceneGraph(threadPool);
+  uint32_t gridNode = sceneGraph->addNode();
+  std::vector<uint32_t> instanceNodes;
+  for (uint32_t i = 0; i < instanceCount; i++) {
+    instanceNodes.push_back(sceneGraph->addNode(gridNode));
+  }
 
-  for (int i = 0; i < framebuffers.size(); ++i) {
-    descriptorSets->update(i, uniformBuffers[i], image);
+  auto frustumCuller = toffoo::core::createFrustumCuller(threadPool);
+  toffoo::core::BoundingVolumes instanceVolumes;
+  instanceVolumes.resize(instanceCount);
+  std::vector<Instance> allInstances(instanceCount);
+  std::vector<uint32_t> visibleInstances;
+  std::vector<uint32_t> instanceLods(instanceCount, 0);
+  std::vector<uint32_t> lodInstanceCounts(cpuLodCount);
+
+  std::string texturePath = "texture.jpg";
+  for (const char *candidate : {"texture.ktx2", "texture.dds"}) {
+    VkFormat format = toffoo::asset::peekTextureFormat(candidate);
+    if (format != VK_FORMAT_UNDEFINED &&
+        toffoo::asset::isFormatSupported(device, format)) {
+      texturePath = candidate;
+      break;
+    }
   }
+  auto residencyManager = toffoo::asset::createResidencyManager(
+      device, commandPool, textureStreamer);
+  auto texture = residencyManager->load(texturePath);
+
+  // The culler reads the transforms as a storage buffer
+  auto instanceRing = toffoo::vk::createRingBuffer(
+      device, sizeof(Instance) * instanceCount, framebuffers.size(),
+      VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+  // Allocations restart at the segment of the frame index, so the offset
+  // recorded here is the one written by the frame loop
+  auto allocateInstances = [&](size_t frameIdx) {
+    instanceRing->beginFrame(frameIdx);
+    return instanceRing->allocate(sizeof(Instance) * instanceCount,
+                                  alignof(Instance));
+  };
 
   toffoo::vk::Semaphore imageAvailable(device);
   toffoo::vk::Semaphore renderFinished(device);
 
-  for (size_t i = 0; i < framebuffers.size(); ++i) {
-    commandBuffers->begin(i);
-    commandBuffers->beginRenderPass(i, renderPass, framebuffers[i],
-                                    swapchain->getExtent());
-    commandBuffers->bindPipeline(i, pipeline);
-    commandBuffers->bindVertexBuffer(i, vertexBuffer, 0);
-    commandBuffers->bindIndexBuffer(i, indexBuffer, 0);
-    descriptorSets->bind(commandBuffers->get(i), i);
-    commandBuffers->draw(i, indices.size(), 1, 0, 0, 0);
-    commandBuffers->endRenderPass(i);
-    commandBuffers->end(i);
-  }
+  // Descriptor sets can't change under recorded command buffers, so both are
+  // rebuilt whenever the streamer swaps the placeholder for the real texture
+  auto recordCommandBuffers = [&]() {
+    for (int i = 0; i < framebuffers.size(); ++i) {
+      if (descriptorBuffer) {
+        descriptorBuffer->update(i, uniformBuffers[i], texture->get());
+        continue;
+      }
+      // The texture may have been reloaded into the handles of the evicted one
+      descriptorSets->invalidate(i);
+      descriptorSets->update(i, uniformBuffers[i], texture->get());
+    }
+
+    commandBuffers = toffoo::vk::createCommandBuffers(device, commandPool,
+                                                      framebuffers.size());
+    for (size_t i = 0; i < framebuffers.size(); ++i) {
+      auto instances = allocateInstances(i);
+      commandBuffers->begin(i);
+      if (culler) {
+        culler->record(commandBuffers->get(i), i, uniformBuffers[i],
+                       instanceRing, instances.offset);
+      }
+      commandBuffers->beginRenderPass(i, renderPass, framebuffers[i],
+                                      swapchain->getExtent());
+      commandBuffers->bindPipeline(i, pipeline);
+      commandBuffers->bindVertexBuffers(
+          i, 0, {meshPool->getVertexBuffer(), instanceRing},
+          {0, instances.offset});
+      commandBuffers->bindIndexBuffer(i, meshPool->getIndexBuffer());
+      if (descriptorBuffer) {
+        descriptorBuffer->bind(commandBuffers->get(i), i);
+      } else {
+        descriptorSets->bind(commandBuffers->get(i), i);
+      }
+      if (culler) {
+        commandBuffers->drawIndexedIndirect(i, culler->getIndirectBuffer(i),
+                                            culler->getObjectCount());
+      } else {
+        commandBuffers->drawIndexedIndirect(i, indirectBuffer, cpuLodCount);
+      }
+      commandBuffers->endRenderPass(i);
+      commandBuffers->end(i);
+    }
+  };
+  recordCommandBuffers();
 
   while (!glfwWindowShouldClose(window)) {
     glfwPollEvents();
+    // The queue is idle here since every frame waits for presentation
+    residencyManager->use(texture);
+    size_t changed = textureStreamer->update();
+    changed += residencyManager->update();
+    if (changed > 0) {
+      recordCommandBuffers();
+    }
     auto nextImg = swapchain->getNextImageIdx(imageAvailable);
+    auto ubo =
+        updateUniformBuffer(uniformBuffers[nextImg], 800, 600, meshTransform);
+    auto *instances = static_cast<Instance *>(allocateInstances(nextImg).data);
+    updateInstances(*sceneGraph, instanceNodes);
+    sceneGraph->update();
+    if (culler) {
+      sceneGraph->copyWorlds(instanceNodes, instances, sizeof(Instance));
+    } else {
+      // Visible instances are packed to the front of the stream grouped by
+      // level of detail, the indirect buffer is free to change as the queue
+      // is idle
+      sceneGraph->copyWorlds(instanceNodes, allInstances.data(),
+                             sizeof(Instance));
+      for (uint32_t i = 0; i < instanceCount; i++) {
+        instanceVolumes.set(i, allInstances[i].transform * ubo.model, meshMin,
+                            meshMax);
+      }
+      auto frustum = toffoo::core::Frustum::fromMatrix(ubo.proj * ubo.view);
+      frustumCuller->cull(instanceVolumes, frustum, visibleInstances);
+
+      toffoo::core::LodSelector lodSelector{
+          .projectionScale = std::abs(ubo.proj[1][1]) *
+                             swapchain->getExtent().height * 0.5f};
+      std::span<const float> errors(lodErrors.data(), cpuLodCount);
+      std::fill(lodInstanceCounts.begin(), lodInstanceCounts.end(), 0);
+      for (uint32_t idx : visibleInstances) {
+        glm::mat4 world = allInstances[idx].transform * ubo.model;
+        float scale = std::max({glm::length(glm::vec3(world[0])),
+                                glm::length(glm::vec3(world[1])),
+                                glm::length(glm::vec3(world[2]))});
+        glm::vec3 center(ubo.view * world * glm::vec4(meshCenter, 1.0f));
+        float distance = glm::length(center) - meshRadius * scale;
+        instanceLods[idx] =
+            lodSelector.select(errors, scale, distance, instanceLods[idx]);
+        lodInstanceCounts[instanceLods[idx]]++;
+      }
+      auto *commands = indirectBuffer->getCommands();
+      uint32_t firstInstance = 0;
+      for (uint32_t level = 0; level < cpuLodCount; level++) {
+        commands[level].firstInstance = firstInstance;
+        commands[level].instanceCount = 0;
+        firstInstance += lodInstanceCounts[level];
+      }
+      for (uint32_t idx : visibleInstances) {
+        auto &command = commands[instanceLods[idx]];
+        instances[command.firstInstance + command.instanceCount++] =
+            allInstances[idx];
+      }
+    }
     commandBuffers->submit(nextImg, imageAvailable, renderFinished);
-    updateUniformBuffer(uniformBuffers[nextImg], 800, 600);
     swapchain->present(nextImg, renderFinished);
     device->waitPresentQueue();
   }
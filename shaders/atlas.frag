@@ -0,0 +1,20 @@
+#version 450
+
+layout(binding = 1) uniform sampler2DArray atlas;
+
+// Same layout as vk::AtlasRegion
+layout(push_constant) uniform PushConstants {
+    vec2 uvOffset;
+    vec2 uvScale;
+    uint layer;
+} pc;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec2 uv = fragTexCoord * pc.uvScale + pc.uvOffset;
+    outColor = texture(atlas, vec3(uv, pc.layer));
+}
@@ -0,0 +1,30 @@
+#version 450
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// Default asset::VertexFormat, the position bounds are folded into ubo.model
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec2 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in mat4 inTransform;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
+
+void main() {
+    gl_Position = ubo.proj * ubo.view * inTransform * ubo.model *
+                  vec4(inPosition, 1.0);
+    fragColor = decodeOctahedral(inNormal) * 0.5 + 0.5;
+    fragTexCoord = inTexCoord;
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+// Packs loose assets into an archive that asset::Archive maps at startup:
+//   cooker <output.pak> <input>...
+// Entries are named after the input file name. SPIR-V is stored as is,
+// KTX2/DDS textures keep their levels and other images are decoded to RGBA8
+// with a full mip chain, so nothing is decoded or generated at load time.
+#include "../asset/Archive.h"
+#include "../asset/PixelConvert.h"
+#include "../asset/TextureLoader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "../thirdparty/stb_image.h"
+
+using namespace toffoo;
+
+static float toLinear(uint8_t value) {
+  float c = value / 255.0f;
+  return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static uint8_t toSrgb(float c) {
+  c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+  return (uint8_t)std::clamp(std::lround(c * 255.0f), 0l, 255l);
+}
+
+// Box filtered in linear space, alpha is averaged as is
+static asset::TextureData cookImage(const std::string &path) {
+  int width, height, channels;
+  stbi_uc *pixels = stbi_load(path.c_str(), &width, &height, &channels, 0);
+  if (!pixels) {
+    throw std::runtime_error("failed to load texture image " + path + "!");
+  }
+
+  asset::TextureData texture{.format = VK_FORMAT_R8G8B8A8_SRGB,
+                             .width = (uint32_t)width,
+                             .height = (uint32_t)height};
+  texture.levels.push_back({0, (size_t)width * height * 4});
+  texture.data.resize(texture.levels[0].size);
+  asset::convertToRgba(pixels, channels,
+                       reinterpret_cast<uint8_t *>(texture.data.data()),
+                       (size_t)width * height);
+  stbi_image_free(pixels);
+
+  uint32_t srcWidth = width;
+  uint32_t srcHeight = height;
+  while (srcWidth > 1 || srcHeight > 1) {
+    uint32_t dstWidth = std::max(srcWidth / 2, 1u);
+    uint32_t dstHeight = std::max(srcHeight / 2, 1u);
+    size_t srcOffset = texture.levels.back().offset;
+    size_t dstOffset = texture.data.size();
+    texture.levels.push_back({dstOffset, (size_t)dstWidth * dstHeight * 4});
+    texture.data.resize(dstOffset + texture.levels.back().size);
+
+    auto src = reinterpret_cast<const uint8_t *>(texture.data.data()) +
+               srcOffset;
+    auto dst = reinterpret_cast<uint8_t *>(texture.data.data()) + dstOffset;
+    for (uint32_t y = 0; y < dstHeight; y++) {
+      for (uint32_t x = 0; x < dstWidth; x++) {
+        uint32_t x0 = std::min(x * 2, srcWidth - 1);
+        uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+        uint32_t y0 = std::min(y * 2, srcHeight - 1);
+        uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+        const uint8_t *texels[4] = {
+            src + (y0 * srcWidth + x0) * 4, src + (y0 * srcWidth + x1) * 4,
+            src + (y1 * srcWidth + x0) * 4, src + (y1 * srcWidth + x1) * 4};
+
+        uint8_t *out = dst + (y * dstWidth + x) * 4;
+        for (int c = 0; c < 3; c++) {
+          float sum = 0.0f;
+          for (auto texel : texels) {
+            sum += toLinear(texel[c]);
+          }
+          out[c] = toSrgb(sum / 4.0f);
+        }
+        uint32_t alpha = 2;
+        for (auto texel : texels) {
+          alpha += texel[3];
+        }
+        out[3] = alpha / 4;
+      }
+    }
+
+    srcWidth = dstWidth;
+    srcHeight = dstHeight;
+  }
+  return texture;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " <output.pak> <input>..."
+              << std::endl;
+    return 1;
+  }
+
+  try {
+    asset::ArchiveWriter writer(argv[1]);
+    for (int i = 2; i < argc; i++) {
+      std::filesystem::path path = argv[i];
+      std::string name = path.filename().string();
+      std::string extension = path.extension().string();
+
+      if (extension == ".spv") {
+        writer.add(name, asset::ArchiveEntryType::Shader,
+                   asset::readFile(path.string()));
+      } else if (extension == ".ktx2" || extension == ".dds") {
+        writer.addTexture(name, asset::loadTexture(path.string()));
+      } else if (extension == ".jpg" || extension == ".png" ||
+                 extension == ".tga" || extension == ".bmp") {
+        writer.addTexture(name, cookImage(path.string()));
+      } else {
+        writer.add(name, asset::ArchiveEntryType::Blob,
+                   asset::readFile(path.string()));
+      }
+      std::cout << "packed " << name << std::endl;
+    }
+    writer.finish();
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,162 @@
+#include "BindlessTextures.h"
+#include "DescriptorSetPool.h"
+#include "Device.h"
+#include "Image.h"
+#include "Pipeline.h"
+#include "Utils.h"
+#include <algorithm>
+
+namespace toffoo::vk {
+BindlessTextures::BindlessTextures(std::shared_ptr<Device> device,
+                                   uint32_t capacity)
+    : device(device) {
+  if (!device->isExtensionEnabled(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+    throw std::runtime_error("descriptor indexing is not supported!");
+  }
+  if (device->getDescriptorBackend() == DescriptorBackend::Buffer) {
+    throw std::runtime_error(
+        "bindless textures require the descriptor set backend!");
+  }
+
+  VkPhysicalDeviceDescriptorIndexingProperties indexingProps{
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES};
+  VkPhysicalDeviceProperties2 props{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+      .pNext = &indexingProps};
+  vkGetPhysicalDeviceProperties2(device->getPhysicalDevice(), &props);
+
+  this->capacity = std::min(
+      {capacity, indexingProps.maxDescriptorSetUpdateAfterBindSamplers,
+       indexingProps.maxDescriptorSetUpdateAfterBindSampledImages,
+       indexingProps.maxPerStageDescriptorUpdateAfterBindSamplers,
+       indexingProps.maxPerStageDescriptorUpdateAfterBindSampledImages});
+
+  VkDescriptorSetLayoutBinding binding{
+      .binding = 0,
+      .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .descriptorCount = this->capacity,
+      .stageFlags = VK_SHADER_STAGE_ALL,
+      .pImmutableSamplers = nullptr};
+
+  layout = std::make_shared<DescriptorSetLayout>(
+      device, std::vector<VkDescriptorSetLayoutBinding>{binding},
+      VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+      std::vector<VkDescriptorBindingFlags>{
+          VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+          VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+          VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT});
+
+  pool = std::make_shared<DescriptorSetPool>(
+      device, 1,
+      std::vector<VkDescriptorPoolSize>{
+          {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, this->capacity}},
+      VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+
+  VkDescriptorSetAllocateInfo allocInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool = pool->handle(),
+      .descriptorSetCount = 1,
+      .pSetLayouts = &layout->handle()};
+
+  VK_THROW_NOT_OK(vkAllocateDescriptorSets(device->handle(), &allocInfo, &set));
+}
+
+std::shared_ptr<DescriptorSetLayout> BindlessTextures::getLayout() {
+  return layout;
+}
+
+uint32_t BindlessTextures::getCapacity() { return capacity; }
+
+void BindlessTextures::write(uint32_t index, std::shared_ptr<Image> image) {
+  VkDescriptorImageInfo imageInfo{
+      .sampler = image->getSampler(),
+      .imageView = image->getView(),
+      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+
+  VkWriteDescriptorSet descriptorWrite{
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = set,
+      .dstBinding = 0,
+      .dstArrayElement = index,
+      .descriptorCount = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .pImageInfo = &imageInfo};
+
+  vkUpdateDescriptorSets(device->handle(), 1, &descriptorWrite, 0, nullptr);
+}
+
+uint32_t BindlessTextures::add(std::shared_ptr<Image> image) {
+  if (!image) {
+    throw std::invalid_argument("bindless texture image is null!");
+  }
+  auto it = indices.find(image.get());
+  if (it != indices.end()) {
+    return it->second;
+  }
+
+  uint32_t index;
+  if (!freeIndices.empty()) {
+    index = freeIndices.back();
+    freeIndices.pop_back();
+  } else if (images.size() < capacity) {
+    index = images.size();
+    images.emplace_back();
+  } else {
+    throw std::runtime_error("bindless texture table is full!");
+  }
+
+  images[index] = image;
+  indices[image.get()] = index;
+  write(index, image);
+  return index;
+}
+
+void BindlessTextures::replace(uint32_t index, std::shared_ptr<Image> image) {
+  // Freed slots are null, reviving one would hand it out twice
+  if (!images.at(index)) {
+    throw std::out_of_range("bindless texture index is not in use!");
+  }
+  if (!image) {
+    throw std::invalid_argument("bindless texture image is null!");
+  }
+  // Images have one index each, so add can hand it back
+  auto it = indices.find(image.get());
+  if (it != indices.end() && it->second != index) {
+    throw std::invalid_argument(
+        "image is registered at another bindless texture index!");
+  }
+  indices.erase(images[index].get());
+  images[index] = image;
+  indices[image.get()] = index;
+  write(index, image);
+}
+
+void BindlessTextures::remove(uint32_t index) {
+  if (!images.at(index)) {
+    throw std::out_of_range("bindless texture index is not in use!");
+  }
+  indices.erase(images[index].get());
+  images[index] = nullptr;
+  freeIndices.push_back(index);
+}
+
+void BindlessTextures::bind(VkCommandBuffer cb,
+                            std::shared_ptr<Pipeline> pipeline,
+                            uint32_t setIdx) {
+  vkCmdBindDescriptorSets(cb, pipeline->getBindPoint(),
+                          pipeline->getLayout()->handle(), setIdx, 1, &set, 0,
+                          nullptr);
+}
+
+VkPushConstantRange
+BindlessTextures::getPushConstantRange(uint32_t offset,
+                                       VkShaderStageFlags stageFlags) {
+  return {.stageFlags = stageFlags, .offset = offset, .size = sizeof(uint32_t)};
+}
+
+std::shared_ptr<BindlessTextures>
+createBindlessTextures(std::shared_ptr<Device> device, uint32_t capacity) {
+  return std::make_shared<BindlessTextures>(device, capacity);
+}
+} // namespace toffoo::vk
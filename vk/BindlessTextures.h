@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class DescriptorSetLayout;
+class DescriptorSetPool;
+class Image;
+class Pipeline;
+
+// One partially bound, update-after-bind array of combined image samplers.
+// Images get a stable index that shaders take via a push constant, so
+// switching textures never needs another descriptor set bind.
+class BindlessTextures {
+private:
+  std::shared_ptr<Device> device;
+
+  std::shared_ptr<DescriptorSetLayout> layout;
+  std::shared_ptr<DescriptorSetPool> pool;
+  VkDescriptorSet set;
+
+  uint32_t capacity;
+
+  std::vector<std::shared_ptr<Image>> images;
+  std::unordered_map<Image *, uint32_t> indices;
+  std::vector<uint32_t> freeIndices;
+
+  void write(uint32_t index, std::shared_ptr<Image> image);
+
+public:
+  BindlessTextures(std::shared_ptr<Device> device, uint32_t capacity);
+
+  std::shared_ptr<DescriptorSetLayout> getLayout();
+
+  uint32_t getCapacity();
+
+  // Returns the index already assigned to the image if it is registered
+  uint32_t add(std::shared_ptr<Image> image);
+
+  // Points an existing index at another image, e.g. to swap a placeholder.
+  // Throws for indices that are not in use and images registered at another
+  // index.
+  void replace(uint32_t index, std::shared_ptr<Image> image);
+
+  // The index is recycled, so the GPU must no longer sample it. Throws for
+  // indices that are not in use.
+  void remove(uint32_t index);
+
+  void bind(VkCommandBuffer cb, std::shared_ptr<Pipeline> pipeline,
+            uint32_t setIdx);
+
+  static VkPushConstantRange
+  getPushConstantRange(uint32_t offset = 0,
+                       VkShaderStageFlags stageFlags =
+                           VK_SHADER_STAGE_FRAGMENT_BIT);
+};
+
+std::shared_ptr<BindlessTextures>
+createBindlessTextures(std::shared_ptr<Device> device,
+                       uint32_t capacity = 16384);
+} // namespace toffoo::vk
@@ -10,6 +10,12 @@ namespace toffoo::vk {
 Buffer::Buffer(std::shared_ptr<Device> device, size_t size,
                VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
     : bufferSize(size), device(device) {
+  bool deviceAddress =
+      device->getDescriptorBackend() == DescriptorBackend::Buffer;
+  if (deviceAddress) {
+    usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+  }
+
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -25,8 +31,13 @@ Buffer::Buffer(std::shared_ptr<Device> device, size_t size,
   vkGetBufferMemoryRequirements(device->handle(), bufferHandle,
                                 &memRequirements);
 
+  VkMemoryAllocateFlagsInfo allocFlags{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+      .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT};
+
   VkMemoryAllocateInfo allocInfo{};
   allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.pNext = deviceAddress ? &allocFlags : nullptr;
   allocInfo.allocationSize = memRequirements.size;
   allocInfo.memoryTypeIndex = findMemoryType(
       device->getPhysicalDevice(), memRequirements.memoryTypeBits,
@@ -44,12 +55,21 @@ VkBuffer Buffer::handle() { return bufferHandle; }
 
 size_t Buffer::size() { return bufferSize; }
 
-void Buffer::fill_from(void *data) {
-  void *mapped_buf;
-  vkMapMemory(device->handle(), vertexBufferMemory, 0, bufferSize, 0,
-              &mapped_buf);
-  memcpy(mapped_buf, data, bufferSize);
-  vkUnmapMemory(device->handle(), vertexBufferMemory);
+void Buffer::fill_from(void *data) { memcpy(map(), data, bufferSize); }
+
+void *Buffer::map() {
+  if (!mapped) {
+    VK_THROW_NOT_OK(vkMapMemory(device->handle(), vertexBufferMemory, 0,
+                                bufferSize, 0, &mapped));
+  }
+  return mapped;
+}
+
+VkDeviceAddress Buffer::getDeviceAddress() {
+  VkBufferDeviceAddressInfo addressInfo{
+      .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+      .buffer = bufferHandle};
+  return vkGetBufferDeviceAddress(device->handle(), &addressInfo);
 }
 
 Buffer::~Buffer() {
@@ -13,6 +13,8 @@ protected:
 
   size_t bufferSize;
 
+  void *mapped = nullptr;
+
   std::shared_ptr<Device> device;
 
 public:
@@ -23,8 +25,14 @@ public:
 
   void fill_from(void *data);
 
+  // Maps the whole buffer once and keeps it mapped until destruction
+  void *map();
+
   size_t size();
 
+  // Only available when the device uses DescriptorBackend::Buffer
+  VkDeviceAddress getDeviceAddress();
+
   virtual ~Buffer();
 
   static void copy(std::shared_ptr<Device> device,
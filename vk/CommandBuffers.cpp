@@ -1,13 +1,17 @@
 #include "CommandBuffers.h"
+#include "Buffer.h"
 #include "CommandPool.h"
 #include "Device.h"
+#include "Fence.h"
 #include "Framebuffer.h"
 #include "IndexBuffer.h"
+#include "IndirectBuffer.h"
 #include "Pipeline.h"
 #include "RenderPass.h"
 #include "Semaphore.h"
 #include "Utils.h"
 #include "VertexBuffer.h"
+#include <algorithm>
 
 namespace toffoo::vk {
 CommandBuffers::CommandBuffers(std::shared_ptr<Device> device,
@@ -22,6 +26,16 @@ CommandBuffers::CommandBuffers(std::shared_ptr<Device> device,
 
   VK_THROW_NOT_OK(
       vkAllocateCommandBuffers(device->handle(), &allocInfo, buffers.data()));
+
+  if (device->isExtensionEnabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)) {
+    cmdPushDescriptorSet = device->getProcAddr<PFN_vkCmdPushDescriptorSetKHR>(
+        "vkCmdPushDescriptorSetKHR");
+  }
+  if (device->isExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+    cmdDrawIndexedIndirectCount =
+        device->getProcAddr<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+            "vkCmdDrawIndexedIndirectCountKHR");
+  }
 }
 
 const VkCommandBuffer &CommandBuffers::get(size_t idx) { return buffers[idx]; }
@@ -53,11 +67,47 @@ void CommandBuffers::beginRenderPass(size_t idx,
 }
 
 void CommandBuffers::bindPipeline(size_t idx,
-                                  std::shared_ptr<GraphicsPipeline> pipeline) {
-  vkCmdBindPipeline(buffers[idx], VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                  std::shared_ptr<Pipeline> pipeline) {
+  vkCmdBindPipeline(buffers[idx], pipeline->getBindPoint(),
                     pipeline->handle());
 }
 
+void CommandBuffers::bindDescriptorSet(size_t idx,
+                                       std::shared_ptr<Pipeline> pipeline,
+                                       VkDescriptorSet set,
+                                       uint32_t firstSet) {
+  vkCmdBindDescriptorSets(buffers[idx], pipeline->getBindPoint(),
+                          pipeline->getLayout()->handle(), firstSet, 1, &set, 0,
+                          nullptr);
+}
+
+void CommandBuffers::pushDescriptors(
+    size_t idx, std::shared_ptr<Pipeline> pipeline, uint32_t set,
+    const std::vector<WriteDescriptorSetWrapper> &writes) {
+  if (!cmdPushDescriptorSet) {
+    throw std::runtime_error("push descriptors are not supported!");
+  }
+
+  std::vector<VkWriteDescriptorSet> descriptorWrites;
+  descriptorWrites.reserve(writes.size());
+  for (auto &w : writes) {
+    descriptorWrites.push_back(w.GetWriteDescriptorSet());
+  }
+
+  cmdPushDescriptorSet(buffers[idx], pipeline->getBindPoint(),
+                       pipeline->getLayout()->handle(), set,
+                       descriptorWrites.size(), descriptorWrites.data());
+}
+
+void CommandBuffers::pushConstants(size_t idx,
+                                   std::shared_ptr<Pipeline> pipeline,
+                                   VkShaderStageFlags stageFlags,
+                                   uint32_t offset, uint32_t size,
+                                   const void *data) {
+  vkCmdPushConstants(buffers[idx], pipeline->getLayout()->handle(), stageFlags,
+                     offset, size, data);
+}
+
 void CommandBuffers::draw(size_t idx, size_t indicesSize, size_t instanceCount,
                           size_t firstIndex, size_t vertexOffset,
                           size_t firstInstance) {
@@ -65,19 +115,87 @@ void CommandBuffers::draw(size_t idx, size_t indicesSize, size_t instanceCount,
                    vertexOffset, firstInstance);
 }
 
+void CommandBuffers::drawIndexedIndirect(
+    size_t idx, std::shared_ptr<IndirectBuffer> indirectBuffer,
+    uint32_t maxDrawCount) {
+  VkBuffer handle = indirectBuffer->handle();
+  VkDeviceSize offset = IndirectBuffer::commandsOffset;
+  uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+  // Without multiDrawIndirect the limit is 1
+  uint32_t maxPerCall =
+      device->getFeatures().multiDrawIndirect
+          ? device->getProperties().limits.maxDrawIndirectCount
+          : 1;
+
+  if (cmdDrawIndexedIndirectCount && maxDrawCount <= maxPerCall) {
+    cmdDrawIndexedIndirectCount(buffers[idx], handle, offset, handle, 0,
+                                maxDrawCount, stride);
+    return;
+  }
+
+  // Unused records have an instanceCount of 0, so splitting the range across
+  // calls draws the same as the count
+  for (uint32_t first = 0; first < maxDrawCount; first += maxPerCall) {
+    vkCmdDrawIndexedIndirect(buffers[idx], handle,
+                             offset + (VkDeviceSize)first * stride,
+                             std::min(maxPerCall, maxDrawCount - first),
+                             stride);
+  }
+}
+
 void CommandBuffers::bindVertexBuffer(
-    size_t idx, std::shared_ptr<VertexBuffer> vertexBuffer, size_t binding) {
-  VkDeviceSize offsets[] = {0};
+    size_t idx, std::shared_ptr<VertexBuffer> vertexBuffer, size_t binding,
+    VkDeviceSize offset) {
   auto handle = vertexBuffer->handle();
-  vkCmdBindVertexBuffers(buffers[idx], binding, 1, &handle, offsets);
+  vkCmdBindVertexBuffers(buffers[idx], binding, 1, &handle, &offset);
+}
+
+void CommandBuffers::bindVertexBuffers(
+    size_t idx, uint32_t firstBinding,
+    const std::vector<std::shared_ptr<Buffer>> &vertexBuffers,
+    const std::vector<VkDeviceSize> &offsets) {
+  if (vertexBuffers.size() != offsets.size()) {
+    throw std::invalid_argument("every vertex buffer needs an offset!");
+  }
+
+  std::vector<VkBuffer> handles;
+  handles.reserve(vertexBuffers.size());
+  for (auto &buffer : vertexBuffers) {
+    handles.push_back(buffer->handle());
+  }
+  vkCmdBindVertexBuffers(buffers[idx], firstBinding, handles.size(),
+                         handles.data(), offsets.data());
 }
 
 void CommandBuffers::bindIndexBuffer(size_t idx,
                                      std::shared_ptr<IndexBuffer> indexBuffer,
-                                     size_t binding) {
-  VkDeviceSize offsets[] = {0};
-  vkCmdBindIndexBuffer(buffers[idx], indexBuffer->handle(), binding,
-                       VK_INDEX_TYPE_UINT16);
+                                     VkDeviceSize offset) {
+  vkCmdBindIndexBuffer(buffers[idx], indexBuffer->handle(), offset,
+                       indexBuffer->getIndexType());
+}
+
+void CommandBuffers::dispatch(size_t idx, uint32_t groupCountX,
+                              uint32_t groupCountY, uint32_t groupCountZ) {
+  vkCmdDispatch(buffers[idx], groupCountX, groupCountY, groupCountZ);
+}
+
+void CommandBuffers::dispatchIndirect(size_t idx,
+                                      std::shared_ptr<Buffer> buffer,
+                                      size_t offset) {
+  vkCmdDispatchIndirect(buffers[idx], buffer->handle(), offset);
+}
+
+void CommandBuffers::memoryBarrier(size_t idx, VkPipelineStageFlags srcStage,
+                                   VkAccessFlags srcAccess,
+                                   VkPipelineStageFlags dstStage,
+                                   VkAccessFlags dstAccess) {
+  VkMemoryBarrier barrier{.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+                          .srcAccessMask = srcAccess,
+                          .dstAccessMask = dstAccess};
+
+  vkCmdPipelineBarrier(buffers[idx], srcStage, dstStage, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
 }
 
 void CommandBuffers::endRenderPass(size_t idx) {
@@ -122,6 +240,22 @@ void CommandBuffers::submit(size_t idx) {
   VK_THROW_NOT_OK(vkQueueWaitIdle(device->getGraphicsQueue()));
 }
 
+void CommandBuffers::submit(size_t idx, Fence &fence) {
+  VkSubmitInfo submitInfo{
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &buffers[idx],
+  };
+
+  VK_THROW_NOT_OK(vkQueueSubmit(device->getGraphicsQueue(), 1, &submitInfo,
+                                fence.handle()));
+}
+
+CommandBuffers::~CommandBuffers() {
+  vkFreeCommandBuffers(device->handle(), pool->handle(), buffers.size(),
+                       buffers.data());
+}
+
 std::shared_ptr<CommandBuffers>
 createCommandBuffers(std::shared_ptr<Device> device,
                      std::shared_ptr<CommandPool> pool, size_t size) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "WriteDescriptorSetWrapper.h"
 #include <memory>
 #include <vector>
 #include <vulkan/vulkan.h>
@@ -9,10 +10,13 @@ class CommandPool;
 class Device;
 class RenderPass;
 class Framebuffer;
-class GraphicsPipeline;
+class Pipeline;
 class Semaphore;
+class Fence;
 class VertexBuffer;
 class IndexBuffer;
+class IndirectBuffer;
+class Buffer;
 
 class CommandBuffers {
 private:
@@ -21,6 +25,9 @@ private:
   std::shared_ptr<Device> device;
   std::shared_ptr<CommandPool> pool;
 
+  PFN_vkCmdPushDescriptorSetKHR cmdPushDescriptorSet = nullptr;
+  PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount = nullptr;
+
 public:
   CommandBuffers(std::shared_ptr<Device> device,
                  std::shared_ptr<CommandPool> pool, size_t size);
@@ -33,17 +40,56 @@ public:
                        std::shared_ptr<Framebuffer> framebuffer,
                        VkExtent2D extent);
 
-  void bindPipeline(size_t idx, std::shared_ptr<GraphicsPipeline> pipeline);
+  void bindPipeline(size_t idx, std::shared_ptr<Pipeline> pipeline);
 
   void bindVertexBuffer(size_t idx, std::shared_ptr<VertexBuffer> vertexBuffer,
-                        size_t binding);
+                        size_t binding, VkDeviceSize offset = 0);
+
+  // Binds vertexBuffers[i] at offsets[i] (bytes) to firstBinding + i. Any
+  // buffer with VK_BUFFER_USAGE_VERTEX_BUFFER_BIT works, e.g. a RingBuffer.
+  void
+  bindVertexBuffers(size_t idx, uint32_t firstBinding,
+                    const std::vector<std::shared_ptr<Buffer>> &vertexBuffers,
+                    const std::vector<VkDeviceSize> &offsets);
 
+  // The index type comes from the buffer, offset is in bytes
   void bindIndexBuffer(size_t idx, std::shared_ptr<IndexBuffer> indexBuffer,
-                       size_t binding);
+                       VkDeviceSize offset = 0);
+
+  void bindDescriptorSet(size_t idx, std::shared_ptr<Pipeline> pipeline,
+                         VkDescriptorSet set, uint32_t firstSet = 0);
+
+  // Records the bindings straight into the command buffer; the set layout
+  // must have been created as a push descriptor layout
+  void pushDescriptors(size_t idx, std::shared_ptr<Pipeline> pipeline,
+                       uint32_t set,
+                       const std::vector<WriteDescriptorSetWrapper> &writes);
+
+  void pushConstants(size_t idx, std::shared_ptr<Pipeline> pipeline,
+                     VkShaderStageFlags stageFlags, uint32_t offset,
+                     uint32_t size, const void *data);
 
   void draw(size_t idx, size_t indicesSize, size_t instanceCount,
             size_t firstIndex, size_t vertexOffset, size_t firstInstance);
 
+  // Draws the commands of indirectBuffer. The GPU reads the draw count from
+  // the buffer with VK_KHR_draw_indirect_count, otherwise all maxDrawCount
+  // records are drawn and unused ones need an instanceCount of 0. Ranges above
+  // maxDrawIndirectCount are split into several draws.
+  void drawIndexedIndirect(size_t idx,
+                           std::shared_ptr<IndirectBuffer> indirectBuffer,
+                           uint32_t maxDrawCount);
+
+  void dispatch(size_t idx, uint32_t groupCountX, uint32_t groupCountY,
+                uint32_t groupCountZ);
+
+  void dispatchIndirect(size_t idx, std::shared_ptr<Buffer> buffer,
+                        size_t offset);
+
+  void memoryBarrier(size_t idx, VkPipelineStageFlags srcStage,
+                     VkAccessFlags srcAccess, VkPipelineStageFlags dstStage,
+                     VkAccessFlags dstAccess);
+
   void endRenderPass(size_t idx);
 
   void end(size_t idx);
@@ -51,6 +97,11 @@ public:
   void submit(size_t idx, Semaphore &waitSemaphore, Semaphore &signalSemaphore);
 
   void submit(size_t idx);
+
+  // Returns right away, the fence signals once the commands have executed
+  void submit(size_t idx, Fence &fence);
+
+  ~CommandBuffers();
 };
 
 std::shared_ptr<CommandBuffers>
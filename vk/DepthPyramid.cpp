@@ -0,0 +1,162 @@
+#include "DepthPyramid.h"
+#include "DescriptorAllocator.h"
+#include "Device.h"
+#include "Image.h"
+#include "MipmapGenerator.h"
+#include "Pipeline.h"
+#include "Shader.h"
+#include "Utils.h"
+#include <algorithm>
+
+namespace toffoo::vk {
+DepthPyramid::DepthPyramid(std::shared_ptr<Device> device,
+                           VkImageView depthView, VkExtent2D depthExtent)
+    : device(device) {
+  if (device->getDescriptorBackend() != DescriptorBackend::Sets) {
+    throw std::runtime_error(
+        "depth pyramid requires the descriptor set backend!");
+  }
+
+  // Halving a power of two keeps every texel covering exactly 2x2 texels of
+  // the level above
+  auto floorPowerOfTwo = [](uint32_t size) {
+    return 1u << (MipmapGenerator::getMipLevels(size, 1) - 1);
+  };
+  uint32_t width = floorPowerOfTwo(depthExtent.width);
+  uint32_t height = floorPowerOfTwo(depthExtent.height);
+  uint32_t levels = MipmapGenerator::getMipLevels(width, height);
+
+  // texelFetch only, the sampler just has to be valid
+  SamplerDesc samplerDesc{.magFilter = VK_FILTER_NEAREST,
+                          .minFilter = VK_FILTER_NEAREST,
+                          .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+                          .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                          .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                          .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+                          .anisotropyEnable = VK_FALSE};
+  pyramid = std::make_shared<Image>(
+      device, width, height, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
+      VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, levels, 1, 0, samplerDesc);
+
+  for (uint32_t i = 0; i < levels; i++) {
+    VkImageViewCreateInfo viewInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = pyramid->handle(),
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = VK_FORMAT_R32_SFLOAT,
+        .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                             .baseMipLevel = i,
+                             .levelCount = 1,
+                             .layerCount = 1}};
+
+    VkImageView view;
+    VK_THROW_NOT_OK(
+        vkCreateImageView(device->handle(), &viewInfo, nullptr, &view));
+    levelViews.push_back(view);
+  }
+
+  ComputePipelineBuilder builder(device);
+  builder.addComputeShader(createShader(device, "depthpyramid.spv"));
+  builder.addDescritorSetLayoutBinding(
+      {.binding = 0,
+       .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+       .descriptorCount = 1,
+       .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT});
+  builder.addDescritorSetLayoutBinding(
+      {.binding = 1,
+       .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+       .descriptorCount = 1,
+       .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT});
+  pipeline = builder.build();
+
+  // The views never change, so every set is written once
+  descriptorAllocator = createDescriptorAllocator(device, 1);
+  for (uint32_t i = 0; i < levels; i++) {
+    std::vector<WriteDescriptorSetWrapper> writes;
+    writes.emplace_back(
+        VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstBinding = 0,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER},
+        VkDescriptorImageInfo{
+            .sampler = pyramid->getSampler(),
+            .imageView = i == 0 ? depthView : levelViews[i - 1],
+            .imageLayout =
+                i == 0 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                       : VK_IMAGE_LAYOUT_GENERAL});
+    writes.emplace_back(
+        VkWriteDescriptorSet{.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                             .dstBinding = 1,
+                             .dstArrayElement = 0,
+                             .descriptorCount = 1,
+                             .descriptorType =
+                                 VK_DESCRIPTOR_TYPE_STORAGE_IMAGE},
+        VkDescriptorImageInfo{.imageView = levelViews[i],
+                              .imageLayout = VK_IMAGE_LAYOUT_GENERAL});
+    levelSets.push_back(descriptorAllocator->allocate(
+        pipeline->getDescriptorSetLayout(), writes));
+  }
+}
+
+std::shared_ptr<Image> DepthPyramid::getImage() { return pyramid; }
+
+void DepthPyramid::record(VkCommandBuffer cb) {
+  // Every level is rewritten, so the old contents are discarded. Waits for
+  // culling that read the pyramid earlier in the frame.
+  VkImageMemoryBarrier barrier{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      .srcAccessMask = 0,
+      .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+      .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = pyramid->handle(),
+      .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                           .levelCount = pyramid->getMipLevels(),
+                           .layerCount = 1}};
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->handle());
+
+  uint32_t width = pyramid->getExtent().width;
+  uint32_t height = pyramid->getExtent().height;
+
+  for (uint32_t i = 0; i < levelSets.size(); i++) {
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            pipeline->getLayout()->handle(), 0, 1,
+                            &levelSets[i], 0, nullptr);
+    vkCmdDispatch(cb, (width + 7) / 8, (height + 7) / 8, 1);
+
+    // The next level reads what this one wrote, culling reads all of them
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.subresourceRange.baseMipLevel = i;
+    barrier.subresourceRange.levelCount = 1;
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &barrier);
+
+    width = std::max(width / 2, 1u);
+    height = std::max(height / 2, 1u);
+  }
+}
+
+DepthPyramid::~DepthPyramid() {
+  for (auto view : levelViews) {
+    vkDestroyImageView(device->handle(), view, nullptr);
+  }
+}
+
+std::shared_ptr<DepthPyramid> createDepthPyramid(std::shared_ptr<Device> device,
+                                                 VkImageView depthView,
+                                                 VkExtent2D depthExtent) {
+  return std::make_shared<DepthPyramid>(device, depthView, depthExtent);
+}
+} // namespace toffoo::vk
\ No newline at end of file
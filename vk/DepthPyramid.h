@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class Image;
+class ComputePipeline;
+class DescriptorAllocator;
+
+// Hierarchical depth (HiZ) of a depth buffer for occlusion culling. Level 0 is
+// the depth buffer rounded down to a power of two, each texel holds the
+// farthest depth of the texels it covers. Built with depthpyramid.spv.
+class DepthPyramid {
+private:
+  std::shared_ptr<Device> device;
+
+  std::shared_ptr<Image> pyramid;
+  std::vector<VkImageView> levelViews;
+
+  std::shared_ptr<ComputePipeline> pipeline;
+  std::shared_ptr<DescriptorAllocator> descriptorAllocator;
+  std::vector<VkDescriptorSet> levelSets;
+
+public:
+  // depthView is read in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL and
+  // must outlive the pyramid
+  DepthPyramid(std::shared_ptr<Device> device, VkImageView depthView,
+               VkExtent2D depthExtent);
+
+  // R32_SFLOAT with a full mip chain, always in VK_IMAGE_LAYOUT_GENERAL
+  std::shared_ptr<Image> getImage();
+
+  // Rebuilds every level from the depth buffer. Recorded after the pass that
+  // writes it, which is responsible for making the depth visible to compute.
+  void record(VkCommandBuffer cb);
+
+  ~DepthPyramid();
+};
+
+std::shared_ptr<DepthPyramid> createDepthPyramid(std::shared_ptr<Device> device,
+                                                 VkImageView depthView,
+                                                 VkExtent2D depthExtent);
+} // namespace toffoo::vk
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "DescriptorAllocator.h"
+#include "DescriptorSetPool.h"
+#include "Device.h"
+#include "Pipeline.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace toffoo::vk {
+static const uint32_t maxSetsPerPool = 4096;
+// Retired pools kept for reuse, the oldest and usually smallest go first
+static const size_t maxFreePools = 16;
+
+static std::map<VkDescriptorType, uint32_t>
+getRequiredDescriptors(DescriptorSetLayout &layout) {
+  std::map<VkDescriptorType, uint32_t> required;
+  for (auto &binding : layout.getBindings()) {
+    required[binding.descriptorType] += binding.descriptorCount;
+  }
+  return required;
+}
+
+// Whether an empty pool has room for one set of the layout
+static bool fits(DescriptorSetPool &pool,
+                 const std::map<VkDescriptorType, uint32_t> &required) {
+  for (auto &[type, count] : required) {
+    auto &sizes = pool.getPoolSizes();
+    auto it = std::find_if(sizes.begin(), sizes.end(), [&](auto &size) {
+      return size.type == type;
+    });
+    if (it == sizes.end() || it->descriptorCount < count) {
+      return false;
+    }
+  }
+  return true;
+}
+
+DescriptorAllocator::DescriptorAllocator(std::shared_ptr<Device> device,
+                                         size_t framesInFlight,
+                                         uint32_t setsPerPool)
+    : frames(framesInFlight), setsPerPool(setsPerPool), device(device) {}
+
+std::shared_ptr<DescriptorSetPool>
+DescriptorAllocator::createPool(std::shared_ptr<DescriptorSetLayout> layout) {
+  // The layout being allocated always fits, however far above the average
+  // its bindings are
+  auto required = getRequiredDescriptors(*layout);
+
+  // Size every descriptor type by how many of it an average set has needed so
+  // far, so pools match the actual workload instead of fixed guesses. The
+  // layout has been counted already.
+  std::vector<VkDescriptorPoolSize> poolSizes;
+  for (auto &[type, count] : observedDescriptors) {
+    double perSet = (double)count / observedSets;
+    uint32_t average = std::ceil(perSet * setsPerPool);
+    poolSizes.push_back({type, std::max({1u, average, required[type]})});
+  }
+
+  return std::make_shared<DescriptorSetPool>(device, setsPerPool, poolSizes);
+}
+
+std::shared_ptr<DescriptorSetPool>
+DescriptorAllocator::grabPool(std::shared_ptr<DescriptorSetLayout> layout) {
+  // Newest first, they were sized from the most observations
+  auto required = getRequiredDescriptors(*layout);
+  for (auto it = freePools.rbegin(); it != freePools.rend(); ++it) {
+    if (fits(**it, required)) {
+      auto pool = *it;
+      freePools.erase(std::next(it).base());
+      return pool;
+    }
+  }
+  return createPool(layout);
+}
+
+void DescriptorAllocator::beginFrame(size_t frameIdx) {
+  this->frameIdx = frameIdx;
+  auto &frame = frames[frameIdx];
+
+  for (auto &pool : frame.exhausted) {
+    pool->reset();
+    freePools.push_back(pool);
+  }
+  frame.exhausted.clear();
+  if (freePools.size() > maxFreePools) {
+    freePools.erase(freePools.begin(), freePools.end() - maxFreePools);
+  }
+
+  if (frame.current) {
+    frame.current->reset();
+  }
+}
+
+VkDescriptorSet
+DescriptorAllocator::allocate(std::shared_ptr<DescriptorSetLayout> layout) {
+  if (layout->isDescriptorBuffer()) {
+    throw std::runtime_error(
+        "descriptor set layout is only usable with descriptor buffers!");
+  }
+  for (auto &binding : layout->getBindings()) {
+    observedDescriptors[binding.descriptorType] += binding.descriptorCount;
+  }
+  observedSets++;
+
+  auto &frame = frames[frameIdx];
+  if (!frame.current) {
+    frame.current = grabPool(layout);
+  }
+
+  VkDescriptorSetAllocateInfo allocInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool = frame.current->handle(),
+      .descriptorSetCount = 1,
+      .pSetLayouts = &layout->handle()};
+
+  VkDescriptorSet set;
+  VkResult result =
+      vkAllocateDescriptorSets(device->handle(), &allocInfo, &set);
+
+  if (result == VK_ERROR_OUT_OF_POOL_MEMORY ||
+      result == VK_ERROR_FRAGMENTED_POOL) {
+    // Chain a free or fresh pool; running out means the frame needs more sets
+    // than we planned for, so grow the pools created from now on
+    frame.exhausted.push_back(frame.current);
+    setsPerPool = std::min(setsPerPool * 2, maxSetsPerPool);
+    frame.current = grabPool(layout);
+
+    allocInfo.descriptorPool = frame.current->handle();
+    result = vkAllocateDescriptorSets(device->handle(), &allocInfo, &set);
+  }
+
+  VK_THROW_NOT_OK(result);
+
+  return set;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(
+    std::shared_ptr<DescriptorSetLayout> layout,
+    const std::vector<WriteDescriptorSetWrapper> &writes) {
+  auto set = allocate(layout);
+
+  std::vector<VkWriteDescriptorSet> descriptorWrites;
+  descriptorWrites.reserve(writes.size());
+  for (auto &w : writes) {
+    descriptorWrites.push_back(w.GetWriteDescriptorSet());
+    descriptorWrites.back().dstSet = set;
+  }
+
+  vkUpdateDescriptorSets(device->handle(), descriptorWrites.size(),
+                         descriptorWrites.data(), 0, nullptr);
+  return set;
+}
+
+std::shared_ptr<DescriptorAllocator>
+createDescriptorAllocator(std::shared_ptr<Device> device,
+                          size_t framesInFlight) {
+  return std::make_shared<DescriptorAllocator>(device, framesInFlight);
+}
+} // namespace toffoo::vk
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "WriteDescriptorSetWrapper.h"
+#include <map>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class DescriptorSetPool;
+class DescriptorSetLayout;
+
+// Hands out transient descriptor sets for the frame being recorded. Pools are
+// chained when one runs out and reset together once the frame has retired.
+class DescriptorAllocator {
+private:
+  struct Frame {
+    std::shared_ptr<DescriptorSetPool> current;
+    std::vector<std::shared_ptr<DescriptorSetPool>> exhausted;
+  };
+
+  std::vector<Frame> frames;
+  size_t frameIdx = 0;
+
+  std::vector<std::shared_ptr<DescriptorSetPool>> freePools;
+
+  std::map<VkDescriptorType, size_t> observedDescriptors;
+  size_t observedSets = 0;
+
+  uint32_t setsPerPool;
+
+  std::shared_ptr<Device> device;
+
+  std::shared_ptr<DescriptorSetPool>
+  createPool(std::shared_ptr<DescriptorSetLayout> layout);
+
+  std::shared_ptr<DescriptorSetPool>
+  grabPool(std::shared_ptr<DescriptorSetLayout> layout);
+
+public:
+  DescriptorAllocator(std::shared_ptr<Device> device, size_t framesInFlight,
+                      uint32_t setsPerPool = 64);
+
+  // The caller guarantees the GPU is done with the sets previously allocated
+  // for this frame index
+  void beginFrame(size_t frameIdx);
+
+  VkDescriptorSet allocate(std::shared_ptr<DescriptorSetLayout> layout);
+
+  VkDescriptorSet
+  allocate(std::shared_ptr<DescriptorSetLayout> layout,
+           const std::vector<WriteDescriptorSetWrapper> &writes);
+};
+
+std::shared_ptr<DescriptorAllocator>
+createDescriptorAllocator(std::shared_ptr<Device> device,
+                          size_t framesInFlight);
+} // namespace toffoo::vk
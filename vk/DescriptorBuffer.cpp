@@ -0,0 +1,219 @@
+#include "DescriptorBuffer.h"
+#include "Buffer.h"
+#include "Device.h"
+#include "Image.h"
+#include "Pipeline.h"
+#include "RingBuffer.h"
+#include "Utils.h"
+#include <cstring>
+
+namespace toffoo::vk {
+DescriptorBuffer::DescriptorBuffer(std::shared_ptr<Device> device,
+                                   std::shared_ptr<Pipeline> pipeline,
+                                   size_t size)
+    : device(device), pipeline(pipeline) {
+  if (device->getDescriptorBackend() != DescriptorBackend::Buffer) {
+    throw std::runtime_error("descriptor buffer backend is not enabled!");
+  }
+
+  getDescriptorSetLayoutSize =
+      device->getProcAddr<PFN_vkGetDescriptorSetLayoutSizeEXT>(
+          "vkGetDescriptorSetLayoutSizeEXT");
+  getDescriptorSetLayoutBindingOffset =
+      device->getProcAddr<PFN_vkGetDescriptorSetLayoutBindingOffsetEXT>(
+          "vkGetDescriptorSetLayoutBindingOffsetEXT");
+  getDescriptor =
+      device->getProcAddr<PFN_vkGetDescriptorEXT>("vkGetDescriptorEXT");
+  cmdBindDescriptorBuffers =
+      device->getProcAddr<PFN_vkCmdBindDescriptorBuffersEXT>(
+          "vkCmdBindDescriptorBuffersEXT");
+  cmdSetDescriptorBufferOffsets =
+      device->getProcAddr<PFN_vkCmdSetDescriptorBufferOffsetsEXT>(
+          "vkCmdSetDescriptorBufferOffsetsEXT");
+
+  properties = {
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT};
+  VkPhysicalDeviceProperties2 props{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+      .pNext = &properties};
+  vkGetPhysicalDeviceProperties2(device->getPhysicalDevice(), &props);
+
+  auto layout = pipeline->getDescriptorSetLayout();
+  if (!layout->isDescriptorBuffer()) {
+    throw std::runtime_error(
+        "descriptor set layout is not usable with descriptor buffers!");
+  }
+
+  getDescriptorSetLayoutSize(device->handle(), layout->handle(), &setSize);
+  VkDeviceSize alignment = properties.descriptorBufferOffsetAlignment;
+  setSize = (setSize + alignment - 1) / alignment * alignment;
+
+  for (auto &b : layout->getBindings()) {
+    getDescriptorSetLayoutBindingOffset(device->handle(), layout->handle(),
+                                        b.binding, &bindingOffsets[b.binding]);
+  }
+
+  buffer = std::make_shared<Buffer>(device, setSize * size, usage,
+                                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  std::memset(buffer->map(), 0, buffer->size());
+}
+
+size_t DescriptorBuffer::getDescriptorSize(VkDescriptorType type) {
+  switch (type) {
+  case VK_DESCRIPTOR_TYPE_SAMPLER:
+    return properties.samplerDescriptorSize;
+  case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+    return properties.combinedImageSamplerDescriptorSize;
+  case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+    return properties.sampledImageDescriptorSize;
+  case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+    return properties.storageImageDescriptorSize;
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    return properties.uniformBufferDescriptorSize;
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+    return properties.storageBufferDescriptorSize;
+  default:
+    throw std::runtime_error("unsupported descriptor buffer type!");
+  }
+}
+
+void DescriptorBuffer::write(
+    char *dst, const std::vector<WriteDescriptorSetWrapper> &writes) {
+  for (auto &w : writes) {
+    auto &descriptorWrite = w.GetWriteDescriptorSet();
+    size_t descriptorSize = getDescriptorSize(descriptorWrite.descriptorType);
+
+    auto offset = bindingOffsets.find(descriptorWrite.dstBinding);
+    if (offset == bindingOffsets.end()) {
+      throw std::runtime_error("descriptor binding is not in the layout!");
+    }
+
+    for (uint32_t i = 0; i < descriptorWrite.descriptorCount; i++) {
+      VkDescriptorAddressInfoEXT addressInfo{
+          .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT};
+      VkDescriptorGetInfoEXT getInfo{
+          .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+          .type = descriptorWrite.descriptorType};
+
+      switch (descriptorWrite.descriptorType) {
+      case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+      case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER: {
+        auto &bufferInfo = descriptorWrite.pBufferInfo[i];
+        if (bufferInfo.range == VK_WHOLE_SIZE) {
+          throw std::runtime_error(
+              "descriptor buffers need an explicit buffer range!");
+        }
+        VkBufferDeviceAddressInfo bufferAddressInfo{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+            .buffer = bufferInfo.buffer};
+        addressInfo.address =
+            vkGetBufferDeviceAddress(device->handle(), &bufferAddressInfo) +
+            bufferInfo.offset;
+        addressInfo.range = bufferInfo.range;
+        if (descriptorWrite.descriptorType ==
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+          getInfo.data.pUniformBuffer = &addressInfo;
+        } else {
+          getInfo.data.pStorageBuffer = &addressInfo;
+        }
+        break;
+      }
+      case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+        getInfo.data.pCombinedImageSampler = &descriptorWrite.pImageInfo[i];
+        break;
+      case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        getInfo.data.pSampledImage = &descriptorWrite.pImageInfo[i];
+        break;
+      case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        getInfo.data.pStorageImage = &descriptorWrite.pImageInfo[i];
+        break;
+      case VK_DESCRIPTOR_TYPE_SAMPLER:
+        getInfo.data.pSampler = &descriptorWrite.pImageInfo[i].sampler;
+        break;
+      default:
+        throw std::runtime_error("unsupported descriptor buffer type!");
+      }
+
+      getDescriptor(device->handle(), &getInfo, descriptorSize,
+                    dst + offset->second +
+                        (descriptorWrite.dstArrayElement + i) * descriptorSize);
+    }
+  }
+}
+
+void DescriptorBuffer::update(size_t idx, std::shared_ptr<Buffer> buffer,
+                              std::shared_ptr<Image> texture) {
+  VkDescriptorBufferInfo bufferInfo{
+      .buffer = buffer->handle(), .offset = 0, .range = buffer->size()};
+
+  VkDescriptorImageInfo imageInfo{
+      .sampler = texture->getSampler(),
+      .imageView = texture->getView(),
+      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+
+  // Same binding assignment as the templated DescriptorSets::update
+  std::vector<WriteDescriptorSetWrapper> writes;
+  for (auto &b : pipeline->getDescriptorSetLayout()->getBindings()) {
+    VkWriteDescriptorSet write{.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                               .dstBinding = b.binding,
+                               .dstArrayElement = 0,
+                               .descriptorCount = 1,
+                               .descriptorType = b.descriptorType};
+    if (b.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+        b.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+      writes.emplace_back(write, bufferInfo);
+    } else {
+      writes.emplace_back(write, imageInfo);
+    }
+  }
+
+  update(idx, writes);
+}
+
+void DescriptorBuffer::update(
+    size_t idx, const std::vector<WriteDescriptorSetWrapper> &writes) {
+  write(static_cast<char *>(buffer->map()) + idx * setSize, writes);
+}
+
+VkDeviceSize
+DescriptorBuffer::write(std::shared_ptr<RingBuffer> ring,
+                        const std::vector<WriteDescriptorSetWrapper> &writes) {
+  auto allocation =
+      ring->allocate(setSize, properties.descriptorBufferOffsetAlignment);
+  write(static_cast<char *>(allocation.data), writes);
+  return allocation.offset;
+}
+
+void DescriptorBuffer::bind(VkCommandBuffer cb, VkDeviceAddress address,
+                            VkBufferUsageFlags bufferUsage,
+                            VkDeviceSize offset) {
+  VkDescriptorBufferBindingInfoEXT bindingInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+      .address = address,
+      .usage = bufferUsage};
+  cmdBindDescriptorBuffers(cb, 1, &bindingInfo);
+
+  uint32_t bufferIndex = 0;
+  cmdSetDescriptorBufferOffsets(cb, pipeline->getBindPoint(),
+                                pipeline->getLayout()->handle(), 0, 1,
+                                &bufferIndex, &offset);
+}
+
+void DescriptorBuffer::bind(VkCommandBuffer cb, size_t idx) {
+  bind(cb, buffer->getDeviceAddress(), usage, idx * setSize);
+}
+
+void DescriptorBuffer::bind(VkCommandBuffer cb,
+                            std::shared_ptr<RingBuffer> ring,
+                            VkDeviceSize offset) {
+  bind(cb, ring->getDeviceAddress(), ring->getUsage(), offset);
+}
+
+std::shared_ptr<DescriptorBuffer>
+createDescriptorBuffer(std::shared_ptr<Device> device,
+                       std::shared_ptr<Pipeline> pipeline, size_t size) {
+  return std::make_shared<DescriptorBuffer>(device, pipeline, size);
+}
+} // namespace toffoo::vk
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "WriteDescriptorSetWrapper.h"
+#include <map>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class Pipeline;
+class Buffer;
+class Image;
+class RingBuffer;
+
+// VK_EXT_descriptor_buffer counterpart of DescriptorSets. Descriptors of set 0
+// are written straight into a persistently mapped buffer and bound by offset.
+class DescriptorBuffer {
+private:
+  std::shared_ptr<Device> device;
+  std::shared_ptr<Pipeline> pipeline;
+  std::shared_ptr<Buffer> buffer;
+
+  static constexpr VkBufferUsageFlags usage =
+      VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT |
+      VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT;
+
+  VkPhysicalDeviceDescriptorBufferPropertiesEXT properties;
+
+  VkDeviceSize setSize;
+  std::map<uint32_t, VkDeviceSize> bindingOffsets;
+
+  PFN_vkGetDescriptorSetLayoutSizeEXT getDescriptorSetLayoutSize;
+  PFN_vkGetDescriptorSetLayoutBindingOffsetEXT
+      getDescriptorSetLayoutBindingOffset;
+  PFN_vkGetDescriptorEXT getDescriptor;
+  PFN_vkCmdBindDescriptorBuffersEXT cmdBindDescriptorBuffers;
+  PFN_vkCmdSetDescriptorBufferOffsetsEXT cmdSetDescriptorBufferOffsets;
+
+  size_t getDescriptorSize(VkDescriptorType type);
+
+  void write(char *dst, const std::vector<WriteDescriptorSetWrapper> &writes);
+
+  void bind(VkCommandBuffer cb, VkDeviceAddress address,
+            VkBufferUsageFlags bufferUsage, VkDeviceSize offset);
+
+public:
+  DescriptorBuffer(std::shared_ptr<Device> device,
+                   std::shared_ptr<Pipeline> pipeline, size_t size);
+
+  void update(size_t idx, std::shared_ptr<Buffer> buffer,
+              std::shared_ptr<Image> texture);
+
+  void update(size_t idx, const std::vector<WriteDescriptorSetWrapper> &writes);
+
+  // Writes a transient set into the current frame segment of the ring, next
+  // to the uniform data it references. Returns the offset to bind.
+  VkDeviceSize write(std::shared_ptr<RingBuffer> ring,
+                     const std::vector<WriteDescriptorSetWrapper> &writes);
+
+  void bind(VkCommandBuffer cb, size_t idx);
+
+  void bind(VkCommandBuffer cb, std::shared_ptr<RingBuffer> ring,
+            VkDeviceSize offset);
+};
+
+std::shared_ptr<DescriptorBuffer>
+createDescriptorBuffer(std::shared_ptr<Device> device,
+                       std::shared_ptr<Pipeline> pipeline, size_t size);
+} // namespace toffoo::vk
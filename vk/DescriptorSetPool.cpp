@@ -1,24 +1,27 @@
 #include "DescriptorSetPool.h"
 #include "Device.h"
+#include "Utils.h"
 
 namespace toffoo::vk {
 DescriptorSetPool::DescriptorSetPool(std::shared_ptr<Device> device,
                                      size_t size)
-    : device(device) {
-  std::array<VkDescriptorPoolSize, 2> poolSizes{};
-
-  // Allocate many descriptors
-  poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-  poolSizes[0].descriptorCount = 4096;
-
-  poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-  poolSizes[1].descriptorCount = 2048;
-
+    : DescriptorSetPool(
+          device, size,
+          // Allocate many descriptors
+          {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4096},
+           {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2048}}) {}
+
+DescriptorSetPool::DescriptorSetPool(
+    std::shared_ptr<Device> device, size_t maxSets,
+    const std::vector<VkDescriptorPoolSize> &poolSizes,
+    VkDescriptorPoolCreateFlags flags)
+    : poolSizes(poolSizes), device(device) {
   VkDescriptorPoolCreateInfo poolInfo{};
   poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  poolInfo.flags = flags;
   poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
   poolInfo.pPoolSizes = poolSizes.data();
-  poolInfo.maxSets = size;
+  poolInfo.maxSets = maxSets;
 
   if (vkCreateDescriptorPool(device->handle(), &poolInfo, nullptr, &pool) !=
       VK_SUCCESS) {
@@ -28,6 +31,14 @@ DescriptorSetPool::DescriptorSetPool(std::shared_ptr<Device> device,
 
 const VkDescriptorPool &DescriptorSetPool::handle() { return pool; }
 
+const std::vector<VkDescriptorPoolSize> &DescriptorSetPool::getPoolSizes() {
+  return poolSizes;
+}
+
+void DescriptorSetPool::reset() {
+  VK_THROW_NOT_OK(vkResetDescriptorPool(device->handle(), pool, 0));
+}
+
 DescriptorSetPool::~DescriptorSetPool() {
   vkDestroyDescriptorPool(device->handle(), pool, nullptr);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include <vulkan/vulkan.h>
 
 namespace toffoo::vk {
@@ -10,13 +11,23 @@ class DescriptorSetPool {
 private:
   VkDescriptorPool pool;
 
+  std::vector<VkDescriptorPoolSize> poolSizes;
+
   std::shared_ptr<Device> device;
 
 public:
   DescriptorSetPool(std::shared_ptr<Device> device, size_t size);
 
+  DescriptorSetPool(std::shared_ptr<Device> device, size_t maxSets,
+                    const std::vector<VkDescriptorPoolSize> &poolSizes,
+                    VkDescriptorPoolCreateFlags flags = 0);
+
   const VkDescriptorPool &handle();
 
+  const std::vector<VkDescriptorPoolSize> &getPoolSizes();
+
+  void reset();
+
   ~DescriptorSetPool();
 };
 
@@ -1,16 +1,23 @@
 #include "DescriptorSets.h"
 #include "Buffer.h"
 #include "DescriptorSetPool.h"
+#include "DescriptorUpdateTemplate.h"
 #include "Device.h"
 #include "Image.h"
 #include "Pipeline.h"
+#include <cstring>
 
 namespace toffoo::vk {
 DescriptorSets::DescriptorSets(std::shared_ptr<Device> device,
                                std::shared_ptr<DescriptorSetPool> pool,
-                               std::shared_ptr<GraphicsPipeline> pipeline,
+                               std::shared_ptr<Pipeline> pipeline,
                                size_t size)
     : device(device), pipeline(pipeline), pool(pool) {
+  if (pipeline->getDescriptorSetLayout()->isDescriptorBuffer()) {
+    throw std::runtime_error(
+        "descriptor set layout is only usable with descriptor buffers!");
+  }
+
   std::vector<VkDescriptorSetLayout> layouts(
       size, pipeline->getDescriptorSetLayout()->handle());
   VkDescriptorSetAllocateInfo allocInfo{};
@@ -20,6 +27,7 @@ DescriptorSets::DescriptorSets(std::shared_ptr<Device> device,
   allocInfo.pSetLayouts = layouts.data();
 
   sets.resize(size);
+  contents.resize(size);
 
   if (vkAllocateDescriptorSets(device->handle(), &allocInfo, sets.data()) !=
       VK_SUCCESS) {
@@ -31,41 +39,62 @@ const VkDescriptorSet &DescriptorSets::get(size_t idx) { return sets[idx]; }
 
 void DescriptorSets::update(size_t idx, std::shared_ptr<Buffer> buffer,
                             std::shared_ptr<Image> texture) {
-  VkDescriptorBufferInfo bufferInfo{};
-  bufferInfo.buffer = buffer->handle();
-  bufferInfo.offset = 0;
-  bufferInfo.range = VK_WHOLE_SIZE;
-
-  VkDescriptorImageInfo imageInfo{};
-  imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  imageInfo.imageView = texture->getView();
-  imageInfo.sampler = texture->getSampler();
-
-  std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
-
-  descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-  descriptorWrites[0].dstSet = sets[idx];
-  descriptorWrites[0].dstBinding = 0;
-  descriptorWrites[0].dstArrayElement = 0;
-  descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-  descriptorWrites[0].descriptorCount = 1;
-  descriptorWrites[0].pBufferInfo = &bufferInfo;
-
-  descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-  descriptorWrites[1].dstSet = sets[idx];
-  descriptorWrites[1].dstBinding = 1;
-  descriptorWrites[1].dstArrayElement = 0;
-  descriptorWrites[1].descriptorType =
-      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-  descriptorWrites[1].descriptorCount = 1;
-  descriptorWrites[1].pImageInfo = &imageInfo;
+  struct {
+    VkDescriptorBufferInfo bufferInfo;
+    VkDescriptorImageInfo imageInfo;
+  } data{};
+
+  data.bufferInfo.buffer = buffer->handle();
+  data.bufferInfo.offset = 0;
+  data.bufferInfo.range = VK_WHOLE_SIZE;
+
+  data.imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  data.imageInfo.imageView = texture->getView();
+  data.imageInfo.sampler = texture->getSampler();
+
+  update(idx, &data);
+}
+
+void DescriptorSets::update(size_t idx, const void *data) {
+  auto updateTemplate = getUpdateTemplate();
+
+  size_t size = updateTemplate->getDataSize();
+  auto &content = contents[idx];
+  if (content.size() == size && memcmp(content.data(), data, size) == 0) {
+    return;
+  }
+
+  updateTemplate->update(sets[idx], data);
+  auto bytes = static_cast<const char *>(data);
+  content.assign(bytes, bytes + size);
+}
+
+void DescriptorSets::invalidate(size_t idx) { contents[idx].clear(); }
+
+std::shared_ptr<DescriptorUpdateTemplate> DescriptorSets::getUpdateTemplate() {
+  if (!updateTemplate) {
+    updateTemplate = createDescriptorUpdateTemplate(
+        device, pipeline->getDescriptorSetLayout());
+  }
+  return updateTemplate;
+}
+
+void DescriptorSets::update(
+    size_t idx, const std::vector<WriteDescriptorSetWrapper> &writes) {
+  std::vector<VkWriteDescriptorSet> descriptorWrites;
+  descriptorWrites.reserve(writes.size());
+  for (auto &w : writes) {
+    descriptorWrites.push_back(w.GetWriteDescriptorSet());
+    descriptorWrites.back().dstSet = sets[idx];
+  }
 
   vkUpdateDescriptorSets(device->handle(), descriptorWrites.size(),
                          descriptorWrites.data(), 0, nullptr);
+  invalidate(idx);
 }
 
 void DescriptorSets::bind(VkCommandBuffer cb, size_t idx) {
-  vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
+  vkCmdBindDescriptorSets(cb, pipeline->getBindPoint(),
                           pipeline->getLayout()->handle(), 0, 1, &sets[idx], 0,
                           nullptr);
 }
@@ -73,7 +102,7 @@ void DescriptorSets::bind(VkCommandBuffer cb, size_t idx) {
 std::shared_ptr<DescriptorSets>
 createDescriptorSets(std::shared_ptr<Device> device,
                      std::shared_ptr<DescriptorSetPool> pool,
-                     std::shared_ptr<GraphicsPipeline> pipeline, size_t size) {
+                     std::shared_ptr<Pipeline> pipeline, size_t size) {
   return std::make_shared<DescriptorSets>(device, pool, pipeline, size);
 }
 } // namespace toffoo::vk
\ No newline at end of file
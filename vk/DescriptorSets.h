@@ -7,34 +7,52 @@
 
 namespace toffoo::vk {
 class Device;
-class GraphicsPipeline;
+class Pipeline;
 class DescriptorSetPool;
 class Buffer;
 class Image;
+class DescriptorUpdateTemplate;
 
 class DescriptorSets {
 private:
   std::vector<VkDescriptorSet> sets;
 
   std::shared_ptr<Device> device;
-  std::shared_ptr<GraphicsPipeline> pipeline;
+  std::shared_ptr<Pipeline> pipeline;
   std::shared_ptr<DescriptorSetPool> pool;
 
+  std::shared_ptr<DescriptorUpdateTemplate> updateTemplate;
+  // Packed data of the last templated update of each set, empty when unknown
+  std::vector<std::vector<char>> contents;
+
 public:
   DescriptorSets(std::shared_ptr<Device> device,
                  std::shared_ptr<DescriptorSetPool> pool,
-                 std::shared_ptr<GraphicsPipeline> pipeline, size_t size);
+                 std::shared_ptr<Pipeline> pipeline, size_t size);
 
   const VkDescriptorSet &get(size_t idx);
 
   void update(size_t idx, std::shared_ptr<Buffer> buffer,
               std::shared_ptr<Image> texture);
 
+  void update(size_t idx, const std::vector<WriteDescriptorSetWrapper> &writes);
+
+  // Writes the set from data packed for getUpdateTemplate(), skipping the
+  // update when the data is byte for byte the one last written. Handles can
+  // be reused once their object is destroyed, so invalidate the set when a
+  // resource it references is.
+  void update(size_t idx, const void *data);
+
+  // Forces the next templated update of the set to be written
+  void invalidate(size_t idx);
+
+  std::shared_ptr<DescriptorUpdateTemplate> getUpdateTemplate();
+
   void bind(VkCommandBuffer cb, size_t idx);
 };
 
 std::shared_ptr<DescriptorSets>
 createDescriptorSets(std::shared_ptr<Device> device,
                      std::shared_ptr<DescriptorSetPool> pool,
-                     std::shared_ptr<GraphicsPipeline> pipeline, size_t size);
+                     std::shared_ptr<Pipeline> pipeline, size_t size);
 } // namespace toffoo::vk
@@ -0,0 +1,109 @@
+#include "DescriptorUpdateTemplate.h"
+#include "Device.h"
+#include "Pipeline.h"
+#include "Utils.h"
+#include <algorithm>
+
+namespace toffoo::vk {
+enum class DescriptorInfoKind { Buffer, Image, TexelBuffer };
+
+static DescriptorInfoKind getDescriptorInfoKind(VkDescriptorType type) {
+  switch (type) {
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+    return DescriptorInfoKind::Buffer;
+  case VK_DESCRIPTOR_TYPE_SAMPLER:
+  case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+  case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+  case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+  case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+    return DescriptorInfoKind::Image;
+  case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+  case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+    return DescriptorInfoKind::TexelBuffer;
+  default:
+    throw std::invalid_argument("unsupported descriptor type for template!");
+  }
+}
+
+static size_t getDescriptorInfoSize(VkDescriptorType type) {
+  switch (getDescriptorInfoKind(type)) {
+  case DescriptorInfoKind::Buffer:
+    return sizeof(VkDescriptorBufferInfo);
+  case DescriptorInfoKind::Image:
+    return sizeof(VkDescriptorImageInfo);
+  default:
+    return sizeof(VkBufferView);
+  }
+}
+
+DescriptorUpdateTemplate::DescriptorUpdateTemplate(
+    std::shared_ptr<Device> device,
+    std::shared_ptr<DescriptorSetLayout> layout)
+    : device(device), layout(layout) {
+  if (layout->isDescriptorBuffer()) {
+    throw std::runtime_error(
+        "descriptor set layout is only usable with descriptor buffers!");
+  }
+
+  auto bindings = layout->getBindings();
+  std::sort(bindings.begin(), bindings.end(),
+            [](const auto &a, const auto &b) { return a.binding < b.binding; });
+
+  for (auto &b : bindings) {
+    if (b.descriptorCount == 0) {
+      continue;
+    }
+
+    size_t stride = getDescriptorInfoSize(b.descriptorType);
+    dataSize = (dataSize + 7) & ~size_t(7);
+    bindingOffsets[b.binding] = dataSize;
+
+    entries.push_back({.dstBinding = b.binding,
+                       .dstArrayElement = 0,
+                       .descriptorCount = b.descriptorCount,
+                       .descriptorType = b.descriptorType,
+                       .offset = dataSize,
+                       .stride = stride});
+
+    dataSize += stride * b.descriptorCount;
+  }
+
+  VkDescriptorUpdateTemplateCreateInfo createInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+      .descriptorUpdateEntryCount = (uint32_t)entries.size(),
+      .pDescriptorUpdateEntries = entries.data(),
+      .templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+      .descriptorSetLayout = layout->handle()};
+
+  VK_THROW_NOT_OK(vkCreateDescriptorUpdateTemplate(
+      device->handle(), &createInfo, nullptr, &updateTemplate));
+}
+
+VkDescriptorUpdateTemplate DescriptorUpdateTemplate::handle() {
+  return updateTemplate;
+}
+
+size_t DescriptorUpdateTemplate::getDataSize() { return dataSize; }
+
+size_t DescriptorUpdateTemplate::getOffset(uint32_t binding) {
+  return bindingOffsets.at(binding);
+}
+
+void DescriptorUpdateTemplate::update(VkDescriptorSet set, const void *data) {
+  vkUpdateDescriptorSetWithTemplate(device->handle(), set, updateTemplate,
+                                    data);
+}
+
+DescriptorUpdateTemplate::~DescriptorUpdateTemplate() {
+  vkDestroyDescriptorUpdateTemplate(device->handle(), updateTemplate, nullptr);
+}
+
+std::shared_ptr<DescriptorUpdateTemplate>
+createDescriptorUpdateTemplate(std::shared_ptr<Device> device,
+                               std::shared_ptr<DescriptorSetLayout> layout) {
+  return std::make_shared<DescriptorUpdateTemplate>(device, layout);
+}
+} // namespace toffoo::vk
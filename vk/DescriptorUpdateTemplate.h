@@ -0,0 +1,46 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class DescriptorSetLayout;
+
+// Update template covering every binding of a descriptor set layout. The
+// packed data holds one Vk*Info per descriptor, bindings in ascending order,
+// each starting at an 8 byte aligned offset, so a plain struct of
+// VkDescriptorBufferInfo/VkDescriptorImageInfo members in binding order
+// matches it.
+class DescriptorUpdateTemplate {
+private:
+  VkDescriptorUpdateTemplate updateTemplate;
+
+  std::vector<VkDescriptorUpdateTemplateEntry> entries;
+  std::map<uint32_t, size_t> bindingOffsets;
+  size_t dataSize = 0;
+
+  std::shared_ptr<Device> device;
+  std::shared_ptr<DescriptorSetLayout> layout;
+
+public:
+  DescriptorUpdateTemplate(std::shared_ptr<Device> device,
+                           std::shared_ptr<DescriptorSetLayout> layout);
+
+  VkDescriptorUpdateTemplate handle();
+
+  size_t getDataSize();
+
+  size_t getOffset(uint32_t binding);
+
+  void update(VkDescriptorSet set, const void *data);
+
+  ~DescriptorUpdateTemplate();
+};
+
+std::shared_ptr<DescriptorUpdateTemplate>
+createDescriptorUpdateTemplate(std::shared_ptr<Device> device,
+                               std::shared_ptr<DescriptorSetLayout> layout);
+} // namespace toffoo::vk
@@ -1,5 +1,6 @@
 #include "Device.h"
 #include "Instance.h"
+#include "SamplerCache.h"
 #include "Surface.h"
 #include "Utils.h"
 #include <cassert>
@@ -9,7 +10,7 @@ namespace toffoo::vk {
 const std::vector<const char *> deviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
-bool checkDeviceExtensionSupport(VkPhysicalDevice device) {
+std::set<std::string> getAvailableExtensions(VkPhysicalDevice device) {
   uint32_t extensionCount;
   vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount,
                                        nullptr);
@@ -18,16 +19,35 @@ bool checkDeviceExtensionSupport(VkPhysicalDevice device) {
   vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount,
                                        availableExtensions.data());
 
-  std::set<std::string> requiredExtensions(deviceExtensions.begin(),
-                                           deviceExtensions.end());
-
+  std::set<std::string> names;
   for (const auto &extension : availableExtensions) {
-    requiredExtensions.erase(extension.extensionName);
+    names.insert(extension.extensionName);
+  }
+  return names;
+}
+
+bool checkDeviceExtensionSupport(VkPhysicalDevice device) {
+  auto availableExtensions = getAvailableExtensions(device);
+
+  for (const auto &extension : deviceExtensions) {
+    if (!availableExtensions.count(extension)) {
+      return false;
+    }
   }
 
-  return requiredExtensions.empty();
+  return true;
 }
 
+// Links extension feature structs into a pNext chain
+struct FeatureChain {
+  void *head = nullptr;
+
+  template <typename T> void add(T &features) {
+    features.pNext = head;
+    head = &features;
+  }
+};
+
 std::vector<VkQueueFamilyProperties> getQueueFamilies(VkPhysicalDevice device) {
   uint32_t queueFamilyCount = 0;
   vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
@@ -109,9 +129,12 @@ VkPhysicalDevice peekDevice(VkInstance instance, VkSurfaceKHR surface) {
 }
 
 Device::Device(std::shared_ptr<Instance> instance,
-               std::shared_ptr<Surface> surface)
-    : instance(instance), surface(surface) {
+               std::shared_ptr<Surface> surface,
+               DescriptorBackend descriptorBackend)
+    : descriptorBackend(DescriptorBackend::Sets), instance(instance),
+      surface(surface) {
   physicalDevice = peekDevice(instance->handle(), surface->handle());
+  vkGetPhysicalDeviceProperties(physicalDevice, &properties);
   findGraphicsFamily(physicalDevice, graphicsFamilyIdx);
   findPresentFamily(physicalDevice, surface->handle(), presentFamilyIdx);
 
@@ -132,24 +155,157 @@ Device::Device(std::shared_ptr<Instance> instance,
          .pQueuePriorities = &queuePriority});
   }
 
-  VkPhysicalDeviceFeatures deviceFeatures{
-      .samplerAnisotropy = VK_TRUE,
+  auto availableExtensions = getAvailableExtensions(physicalDevice);
+  auto isAvailable = [&](const char *name) {
+    return availableExtensions.count(name) > 0;
   };
 
+  VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT supportedGplFeatures{
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT};
+
+  VkPhysicalDeviceDescriptorIndexingFeatures supportedIndexingFeatures{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES};
+
+  VkPhysicalDeviceBufferDeviceAddressFeatures supportedAddressFeatures{
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES};
+
+  VkPhysicalDeviceDescriptorBufferFeaturesEXT supportedDescriptorBufferFeatures{
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT};
+
+  VkPhysicalDeviceIndexTypeUint8FeaturesEXT supportedUint8Features{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT};
+
+  FeatureChain supportedChain;
+  supportedChain.add(supportedAddressFeatures);
+  if (isAvailable(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME)) {
+    supportedChain.add(supportedUint8Features);
+  }
+  if (isAvailable(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME)) {
+    supportedChain.add(supportedDescriptorBufferFeatures);
+  }
+  if (isAvailable(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+    supportedChain.add(supportedGplFeatures);
+  }
+  if (isAvailable(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+    supportedChain.add(supportedIndexingFeatures);
+  }
+
+  VkPhysicalDeviceFeatures2 supportedFeatures{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+      .pNext = supportedChain.head};
+  vkGetPhysicalDeviceFeatures2(physicalDevice, &supportedFeatures);
+
+  std::vector<const char *> extensions(deviceExtensions);
+  FeatureChain enabledChain;
+
+  VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT gplFeatures{
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+      .graphicsPipelineLibrary = VK_TRUE};
+  if (isAvailable(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+      supportedGplFeatures.graphicsPipelineLibrary) {
+    extensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+    extensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+    enabledChain.add(gplFeatures);
+  }
+
+  VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+      .shaderSampledImageArrayNonUniformIndexing = VK_TRUE,
+      .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+      .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+      .descriptorBindingPartiallyBound = VK_TRUE,
+      .runtimeDescriptorArray = VK_TRUE};
+  bool hasDescriptorIndexing =
+      supportedIndexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+      supportedIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind &&
+      supportedIndexingFeatures.descriptorBindingUpdateUnusedWhilePending &&
+      supportedIndexingFeatures.descriptorBindingPartiallyBound &&
+      supportedIndexingFeatures.runtimeDescriptorArray;
+  if (hasDescriptorIndexing) {
+    extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    enabledChain.add(indexingFeatures);
+  }
+
+  if (isAvailable(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)) {
+    extensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+  }
+
+  if (isAvailable(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+    extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  }
+
+  VkPhysicalDeviceIndexTypeUint8FeaturesEXT uint8Features{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT,
+      .indexTypeUint8 = VK_TRUE};
+  if (supportedUint8Features.indexTypeUint8) {
+    extensions.push_back(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME);
+    enabledChain.add(uint8Features);
+  }
+
+  VkPhysicalDeviceBufferDeviceAddressFeatures addressFeatures{
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES,
+      .bufferDeviceAddress = VK_TRUE};
+  VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures{
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+      .descriptorBuffer = VK_TRUE,
+      .descriptorBufferPushDescriptors =
+          supportedDescriptorBufferFeatures.descriptorBufferPushDescriptors &&
+          isAvailable(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)};
+  // The extension also depends on descriptor indexing and synchronization2
+  if (descriptorBackend == DescriptorBackend::Buffer &&
+      supportedDescriptorBufferFeatures.descriptorBuffer &&
+      supportedAddressFeatures.bufferDeviceAddress &&
+      isAvailable(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) &&
+      hasDescriptorIndexing) {
+    extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    extensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+    enabledChain.add(addressFeatures);
+    enabledChain.add(descriptorBufferFeatures);
+    this->descriptorBackend = DescriptorBackend::Buffer;
+    descriptorBufferPushDescriptors =
+        descriptorBufferFeatures.descriptorBufferPushDescriptors;
+  }
+
+  if (isAvailable(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)) {
+    extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+  }
+
+  const auto &supported = supportedFeatures.features;
+  features = {.fullDrawIndexUint32 = supported.fullDrawIndexUint32,
+              .multiDrawIndirect = supported.multiDrawIndirect,
+              .drawIndirectFirstInstance = supported.drawIndirectFirstInstance,
+              .samplerAnisotropy = VK_TRUE};
+
+  VkPhysicalDeviceFeatures2 deviceFeatures{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+      .pNext = enabledChain.head,
+      .features = features};
+
   VkDeviceCreateInfo createInfo{
       .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+      .pNext = &deviceFeatures,
       .queueCreateInfoCount = (uint32_t)queueCreateInfos.size(),
       .pQueueCreateInfos = queueCreateInfos.data(),
-      .enabledExtensionCount = (uint32_t)deviceExtensions.size(),
-      .ppEnabledExtensionNames = deviceExtensions.data(),
-      .pEnabledFeatures = &deviceFeatures};
+      .enabledExtensionCount = (uint32_t)extensions.size(),
+      .ppEnabledExtensionNames = extensions.data(),
+      .pEnabledFeatures = nullptr};
 
   VK_THROW_NOT_OK(
       vkCreateDevice(physicalDevice, &createInfo, nullptr, &device));
 
+  enabledExtensions.insert(extensions.begin(), extensions.end());
+
   vkGetDeviceQueue(device, graphicsFamilyIdx, 0, &graphicsQueue);
   vkGetDeviceQueue(device, presentFamilyIdx, 0, &presentQueue);
 
+  samplerCache = std::make_unique<SamplerCache>(device, properties.limits);
+
   // TODO: we currently expect them to be equal to use VK_SHARING_MODE_EXCLUSIVE
   // mode in swapchain but it is not always true
   assert(graphicsFamilyIdx == presentFamilyIdx);
@@ -163,19 +319,39 @@ VkQueue Device::getPresentQueue() { return presentQueue; }
 
 VkPhysicalDevice Device::getPhysicalDevice() { return physicalDevice; }
 
+const VkPhysicalDeviceProperties &Device::getProperties() { return properties; }
+
+const VkPhysicalDeviceFeatures &Device::getFeatures() { return features; }
+
+SamplerCache &Device::getSamplerCache() { return *samplerCache; }
+
 std::shared_ptr<Surface> Device::getSurface() { return surface; }
 
+bool Device::isExtensionEnabled(const char *name) {
+  return enabledExtensions.count(name) > 0;
+}
+
+DescriptorBackend Device::getDescriptorBackend() { return descriptorBackend; }
+
+bool Device::hasDescriptorBufferPushDescriptors() {
+  return descriptorBufferPushDescriptors;
+}
+
 uint32_t Device::getGraphicsFamilyIdx() { return graphicsFamilyIdx; }
 uint32_t Device::getPresentFamilyIdx() { return presentFamilyIdx; }
 
-Device::~Device() { vkDestroyDevice(device, nullptr); }
+Device::~Device() {
+  samplerCache.reset();
+  vkDestroyDevice(device, nullptr);
+}
 
 void Device::waitIdle() { vkDeviceWaitIdle(device); }
 
 void Device::waitPresentQueue() { vkQueueWaitIdle(presentQueue); }
 
 std::shared_ptr<Device> createDevice(std::shared_ptr<Instance> instance,
-                                     std::shared_ptr<Surface> surface) {
-  return std::make_shared<Device>(instance, surface);
+                                     std::shared_ptr<Surface> surface,
+                                     DescriptorBackend descriptorBackend) {
+  return std::make_shared<Device>(instance, surface, descriptorBackend);
 }
 } // namespace toffoo::vk
\ No newline at end of file
@@ -1,15 +1,28 @@
 #pragma once
 
 #include <memory>
+#include <set>
+#include <string>
 #include <vulkan/vulkan.h>
 namespace toffoo::vk {
 class Instance;
 class Surface;
+class SamplerCache;
+
+enum class DescriptorBackend {
+  // Descriptor sets allocated from pools (DescriptorSets)
+  Sets,
+  // VK_EXT_descriptor_buffer, descriptors written into mapped memory
+  // (DescriptorBuffer)
+  Buffer,
+};
 
 class Device {
 private:
   VkDevice device;
   VkPhysicalDevice physicalDevice;
+  VkPhysicalDeviceProperties properties;
+  VkPhysicalDeviceFeatures features;
 
   uint32_t graphicsFamilyIdx;
   uint32_t presentFamilyIdx;
@@ -17,11 +30,19 @@ private:
   VkQueue graphicsQueue;
   VkQueue presentQueue;
 
+  std::set<std::string> enabledExtensions;
+
+  DescriptorBackend descriptorBackend;
+  bool descriptorBufferPushDescriptors = false;
+
+  std::unique_ptr<SamplerCache> samplerCache;
+
   std::shared_ptr<Instance> instance;
   std::shared_ptr<Surface> surface;
 
 public:
-  Device(std::shared_ptr<Instance> instance, std::shared_ptr<Surface> surface);
+  Device(std::shared_ptr<Instance> instance, std::shared_ptr<Surface> surface,
+         DescriptorBackend descriptorBackend);
 
   VkDevice handle();
 
@@ -30,17 +51,39 @@ public:
 
   VkPhysicalDevice getPhysicalDevice();
 
+  const VkPhysicalDeviceProperties &getProperties();
+
+  // Core features the device was created with
+  const VkPhysicalDeviceFeatures &getFeatures();
+
   std::shared_ptr<Surface> getSurface();
 
   VkQueue getGraphicsQueue();
   VkQueue getPresentQueue();
 
+  bool isExtensionEnabled(const char *name);
+
+  // Falls back to DescriptorBackend::Sets when the requested backend is not
+  // supported by the GPU
+  DescriptorBackend getDescriptorBackend();
+
+  // Push descriptor layouts can be used with DescriptorBackend::Buffer
+  bool hasDescriptorBufferPushDescriptors();
+
+  SamplerCache &getSamplerCache();
+
+  template <typename T> T getProcAddr(const char *name) {
+    return reinterpret_cast<T>(vkGetDeviceProcAddr(device, name));
+  }
+
   void waitIdle();
   void waitPresentQueue();
 
   ~Device();
 };
 
-std::shared_ptr<Device> createDevice(std::shared_ptr<Instance> instance,
-                                     std::shared_ptr<Surface> surface);
+std::shared_ptr<Device>
+createDevice(std::shared_ptr<Instance> instance,
+             std::shared_ptr<Surface> surface,
+             DescriptorBackend descriptorBackend = DescriptorBackend::Sets);
 } // namespace toffoo::vk
\ No newline at end of file
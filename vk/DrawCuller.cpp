@@ -0,0 +1,183 @@
+#include "DrawCuller.h"
+#include "DepthPyramid.h"
+#include "DescriptorAllocator.h"
+#include "Device.h"
+#include "Image.h"
+#include "IndirectBuffer.h"
+#include "Pipeline.h"
+#include "Shader.h"
+#include "StorageBuffer.h"
+#include "UniformBuffer.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace toffoo::vk {
+struct CullPushConstants {
+  uint32_t objectCount;
+  uint32_t compact;
+  float viewportHeight;
+  float lodThreshold;
+  float lodHysteresis;
+};
+
+DrawCuller::DrawCuller(std::shared_ptr<Device> device, uint32_t maxObjects,
+                       uint32_t maxLods, size_t framesInFlight,
+                       std::shared_ptr<DepthPyramid> depthPyramid)
+    : device(device), maxObjects(maxObjects), maxLods(maxLods),
+      depthPyramid(depthPyramid) {
+  if (device->getDescriptorBackend() != DescriptorBackend::Sets) {
+    throw std::runtime_error("culling requires the descriptor set backend!");
+  }
+  if (!device->getFeatures().drawIndirectFirstInstance) {
+    throw std::runtime_error("culling requires drawIndirectFirstInstance!");
+  }
+
+  objects = createStorageBuffer(device, maxObjects * sizeof(DrawObject));
+  lods = createStorageBuffer(device, maxLods * sizeof(DrawLod));
+  for (size_t i = 0; i < framesInFlight; i++) {
+    indirectBuffers.push_back(createIndirectBuffer(device, maxObjects));
+    lodLevels.push_back(
+        createStorageBuffer(device, maxObjects * sizeof(uint32_t)));
+  }
+
+  ComputePipelineBuilder builder(device);
+  builder.addComputeShader(createShader(
+      device, depthPyramid ? "cull_occlusion.spv" : "cull.spv"));
+  builder.addDescritorSetLayoutBinding(
+      {.binding = 0,
+       .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+       .descriptorCount = 1,
+       .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT});
+  for (uint32_t binding : {1u, 2u, 3u, 4u, 5u, 6u}) {
+    builder.addDescritorSetLayoutBinding(
+        StorageBuffer::getDescriptorSetLayoutBinding(binding));
+  }
+  if (depthPyramid) {
+    builder.addDescritorSetLayoutBinding(
+        {.binding = 7,
+         .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+         .descriptorCount = 1,
+         .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT});
+  }
+  builder.addPushConstantRange(
+      {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants)});
+  pipeline = builder.build();
+
+  descriptorAllocator = createDescriptorAllocator(device, framesInFlight);
+}
+
+void DrawCuller::setObjects(const std::vector<DrawObject> &drawObjects,
+                            const std::vector<DrawLod> &drawLods) {
+  if (drawObjects.size() > maxObjects || drawLods.size() > maxLods) {
+    throw std::out_of_range("too many objects for the culler!");
+  }
+  memcpy(objects->map(), drawObjects.data(),
+         drawObjects.size() * sizeof(DrawObject));
+  memcpy(lods->map(), drawLods.data(), drawLods.size() * sizeof(DrawLod));
+  for (auto &levels : lodLevels) {
+    memset(levels->map(), 0, levels->size());
+  }
+  objectCount = drawObjects.size();
+}
+
+void DrawCuller::setLodSelection(float viewportHeight, float threshold,
+                                 float hysteresis) {
+  this->viewportHeight = viewportHeight;
+  lodThreshold = threshold;
+  lodHysteresis = hysteresis;
+}
+
+uint32_t DrawCuller::getObjectCount() { return objectCount; }
+
+std::shared_ptr<IndirectBuffer> DrawCuller::getIndirectBuffer(size_t frameIdx) {
+  return indirectBuffers[frameIdx];
+}
+
+void DrawCuller::record(VkCommandBuffer cb, size_t frameIdx,
+                        std::shared_ptr<UniformBuffer> uniforms,
+                        std::shared_ptr<Buffer> transforms,
+                        VkDeviceSize transformsOffset) {
+  auto indirectBuffer = indirectBuffers[frameIdx];
+  auto previousLodLevels =
+      lodLevels[(frameIdx + lodLevels.size() - 1) % lodLevels.size()];
+
+  std::vector<WriteDescriptorSetWrapper> writes;
+  writes.push_back(uniforms->getWriteDescriptorSet(0));
+  writes.push_back(objects->getWriteDescriptorSet(1));
+  writes.emplace_back(
+      VkWriteDescriptorSet{.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                           .dstBinding = 2,
+                           .dstArrayElement = 0,
+                           .descriptorCount = 1,
+                           .descriptorType =
+                               VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+      VkDescriptorBufferInfo{.buffer = transforms->handle(),
+                             .offset = transformsOffset,
+                             .range = VK_WHOLE_SIZE});
+  writes.push_back(indirectBuffer->getWriteDescriptorSet(3));
+  writes.push_back(lods->getWriteDescriptorSet(4));
+  writes.push_back(previousLodLevels->getWriteDescriptorSet(5));
+  writes.push_back(lodLevels[frameIdx]->getWriteDescriptorSet(6));
+  if (depthPyramid) {
+    auto image = depthPyramid->getImage();
+    writes.emplace_back(
+        VkWriteDescriptorSet{
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstBinding = 7,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER},
+        VkDescriptorImageInfo{.sampler = image->getSampler(),
+                              .imageView = image->getView(),
+                              .imageLayout = VK_IMAGE_LAYOUT_GENERAL});
+  }
+
+  descriptorAllocator->beginFrame(frameIdx);
+  VkDescriptorSet set = descriptorAllocator->allocate(
+      pipeline->getDescriptorSetLayout(), writes);
+
+  // Appending starts from a zero count. The compute source also orders this
+  // dispatch after the one of the previous frame, whose levels it reads.
+  vkCmdFillBuffer(cb, indirectBuffer->handle(), 0, sizeof(uint32_t), 0);
+  VkMemoryBarrier barrier{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask =
+          VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+  vkCmdPipelineBarrier(
+      cb, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0,
+      nullptr);
+
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->handle());
+  vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          pipeline->getLayout()->handle(), 0, 1, &set, 0,
+                          nullptr);
+
+  CullPushConstants constants{
+      .objectCount = objectCount,
+      .compact = device->isExtensionEnabled(
+          VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME),
+      .viewportHeight = viewportHeight,
+      .lodThreshold = lodThreshold,
+      .lodHysteresis = lodHysteresis};
+  vkCmdPushConstants(cb, pipeline->getLayout()->handle(),
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants),
+                     &constants);
+  vkCmdDispatch(cb, (objectCount + 63) / 64, 1, 1);
+
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
+}
+
+std::shared_ptr<DrawCuller>
+createDrawCuller(std::shared_ptr<Device> device, uint32_t maxObjects,
+                 uint32_t maxLods, size_t framesInFlight,
+                 std::shared_ptr<DepthPyramid> depthPyramid) {
+  return std::make_shared<DrawCuller>(device, maxObjects, maxLods,
+                                      framesInFlight, depthPyramid);
+}
+} // namespace toffoo::vk
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class Buffer;
+class StorageBuffer;
+class UniformBuffer;
+class IndirectBuffer;
+class DepthPyramid;
+class ComputePipeline;
+class DescriptorAllocator;
+
+// One culled object, matches DrawObject in shaders/cull.comp
+struct DrawObject {
+  // Center and radius in the space the model matrix of the uniforms applies to
+  glm::vec4 boundingSphere;
+  // Levels of detail of the mesh, from the full one to the coarsest
+  uint32_t firstLod;
+  uint32_t lodCount;
+  int32_t vertexOffset;
+  uint32_t padding = 0;
+};
+
+// One level of detail, matches DrawLod in shaders/cull.comp
+struct DrawLod {
+  uint32_t firstIndex;
+  uint32_t indexCount;
+  // Deviation in the space of the bounding sphere, see core::LodSelector
+  float error;
+  uint32_t padding = 0;
+};
+
+// Culls objects on the GPU against the view frustum and, with a DepthPyramid,
+// against the depth of the previous frame (cull.spv or cull_occlusion.spv).
+// Object i draws one instance with firstInstance i, so its transform is read
+// from the instance stream like for a regular instanced draw. The level of
+// detail is picked per object like core::LodSelector does.
+//
+// With VK_KHR_draw_indirect_count the visible draws are compacted and counted,
+// otherwise hidden objects keep their record with an instanceCount of 0.
+class DrawCuller {
+private:
+  std::shared_ptr<Device> device;
+
+  uint32_t maxObjects;
+  uint32_t maxLods;
+  uint32_t objectCount = 0;
+
+  float viewportHeight = 0.0f;
+  float lodThreshold = 1.0f;
+  float lodHysteresis = 0.25f;
+
+  std::shared_ptr<StorageBuffer> objects;
+  std::shared_ptr<StorageBuffer> lods;
+  // Per frame, so frames in flight never write the same levels
+  std::vector<std::shared_ptr<StorageBuffer>> lodLevels;
+  std::vector<std::shared_ptr<IndirectBuffer>> indirectBuffers;
+  std::shared_ptr<DepthPyramid> depthPyramid;
+
+  std::shared_ptr<ComputePipeline> pipeline;
+  std::shared_ptr<DescriptorAllocator> descriptorAllocator;
+
+public:
+  DrawCuller(std::shared_ptr<Device> device, uint32_t maxObjects,
+             uint32_t maxLods, size_t framesInFlight,
+             std::shared_ptr<DepthPyramid> depthPyramid = nullptr);
+
+  // Objects refer to drawLods by index. Resets the level of every object to
+  // the full mesh.
+  void setObjects(const std::vector<DrawObject> &drawObjects,
+                  const std::vector<DrawLod> &drawLods);
+
+  // Errors are compared in pixels of a viewport this high, until it is set
+  // every object draws its full mesh. Applies to the next recording.
+  void setLodSelection(float viewportHeight, float threshold = 1.0f,
+                       float hysteresis = 0.25f);
+
+  uint32_t getObjectCount();
+
+  // Draws for CommandBuffers::drawIndexedIndirect with getObjectCount() as
+  // maxDrawCount
+  std::shared_ptr<IndirectBuffer> getIndirectBuffer(size_t frameIdx);
+
+  // Recorded outside of a render pass, the draws are ready for the indirect
+  // stage afterwards. uniforms are the ones of the vertex shaders, transforms
+  // holds one glm::mat4 per object from transformsOffset on, which must be a
+  // multiple of minStorageBufferOffsetAlignment. The GPU must be done with the
+  // previous recording for frameIdx. Levels are written to the buffer of
+  // frameIdx and read from the one of frameIdx - 1, which a barrier orders
+  // after earlier submissions to the same queue.
+  void record(VkCommandBuffer cb, size_t frameIdx,
+              std::shared_ptr<UniformBuffer> uniforms,
+              std::shared_ptr<Buffer> transforms,
+              VkDeviceSize transformsOffset);
+};
+
+std::shared_ptr<DrawCuller>
+createDrawCuller(std::shared_ptr<Device> device, uint32_t maxObjects,
+                 uint32_t maxLods, size_t framesInFlight,
+                 std::shared_ptr<DepthPyramid> depthPyramid = nullptr);
+} // namespace toffoo::vk
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "Fence.h"
+#include "Device.h"
+#include "Utils.h"
+namespace toffoo::vk {
+
+Fence::Fence(std::shared_ptr<Device> device, bool signaled) : device(device) {
+  VkFenceCreateInfo fenceInfo{
+      .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+      .flags = signaled ? VK_FENCE_CREATE_SIGNALED_BIT : 0u};
+  VK_THROW_NOT_OK(vkCreateFence(device->handle(), &fenceInfo, nullptr, &fence));
+}
+
+VkFence Fence::handle() { return fence; }
+
+bool Fence::isSignaled() {
+  return vkGetFenceStatus(device->handle(), fence) == VK_SUCCESS;
+}
+
+void Fence::wait(uint64_t timeout) {
+  VK_THROW_NOT_OK(
+      vkWaitForFences(device->handle(), 1, &fence, VK_TRUE, timeout));
+}
+
+void Fence::reset() {
+  VK_THROW_NOT_OK(vkResetFences(device->handle(), 1, &fence));
+}
+
+Fence::~Fence() { vkDestroyFence(device->handle(), fence, nullptr); }
+
+std::shared_ptr<Fence> createFence(std::shared_ptr<Device> device,
+                                   bool signaled) {
+  return std::make_shared<Fence>(device, signaled);
+}
+} // namespace toffoo::vk
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vulkan/vulkan.h>
+namespace toffoo::vk {
+class Device;
+class Fence {
+private:
+  VkFence fence;
+
+  std::shared_ptr<Device> device;
+
+public:
+  Fence(std::shared_ptr<Device> device, bool signaled = false);
+  VkFence handle();
+
+  // Non-blocking check, lets the render loop poll for finished work
+  bool isSignaled();
+  void wait(uint64_t timeout = UINT64_MAX);
+  void reset();
+
+  ~Fence();
+};
+
+std::shared_ptr<Fence> createFence(std::shared_ptr<Device> device,
+                                   bool signaled = false);
+} // namespace toffoo::vk
@@ -2,28 +2,32 @@
 #include "Buffer.h"
 #include "CommandBuffers.h"
 #include "Device.h"
+#include "MipmapGenerator.h"
 #include "Utils.h"
 
 namespace toffoo::vk {
 Image::Image(std::shared_ptr<Device> device, size_t width, size_t height,
              VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-             VkMemoryPropertyFlags properties)
-    : device(device) {
+             VkMemoryPropertyFlags properties, uint32_t mipLevels,
+             uint32_t arrayLayers, VkImageCreateFlags flags,
+             const SamplerDesc &samplerDesc)
+    : format(format), extent{(uint32_t)width, (uint32_t)height},
+      mipLevels(mipLevels), arrayLayers(arrayLayers), device(device) {
   VkImageCreateInfo imageInfo{};
   imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imageInfo.imageType = VK_IMAGE_TYPE_2D;
   imageInfo.extent.width = width;
   imageInfo.extent.height = height;
   imageInfo.extent.depth = 1;
-  imageInfo.mipLevels = 1;
-  imageInfo.arrayLayers = 1;
+  imageInfo.mipLevels = mipLevels;
+  imageInfo.arrayLayers = arrayLayers;
   imageInfo.format = format;
   imageInfo.tiling = tiling;
   imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
   imageInfo.usage = usage;
   imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
   imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-  imageInfo.flags = 0; // Optional
+  imageInfo.flags = flags;
 
   if (vkCreateImage(device->handle(), &imageInfo, nullptr, &textureImage) !=
       VK_SUCCESS) {
@@ -37,6 +41,7 @@ Image::Image(std::shared_ptr<Device> device, size_t width, size_t height,
   VkMemoryAllocateInfo allocInfo{};
   allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
   allocInfo.allocationSize = memRequirements.size;
+  memorySize = memRequirements.size;
   allocInfo.memoryTypeIndex = findMemoryType(
       device->getPhysicalDevice(), memRequirements.memoryTypeBits,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
@@ -48,47 +53,32 @@ Image::Image(std::shared_ptr<Device> device, size_t width, size_t height,
 
   vkBindImageMemory(device->handle(), textureImage, textureImageMemory, 0);
 
+  // Usages only meant for aliased views (e.g. storage on an sRGB image) must
+  // not leak into the default view
+  VkImageViewUsageCreateInfo viewUsageInfo{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO,
+      .usage = usage & ~VK_IMAGE_USAGE_STORAGE_BIT};
+
   VkImageViewCreateInfo viewInfo{};
   viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.pNext =
+      (flags & VK_IMAGE_CREATE_EXTENDED_USAGE_BIT) ? &viewUsageInfo : nullptr;
   viewInfo.image = textureImage;
-  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-  viewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+  viewInfo.viewType =
+      arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+  viewInfo.format = format;
   viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
   viewInfo.subresourceRange.baseMipLevel = 0;
-  viewInfo.subresourceRange.levelCount = 1;
+  viewInfo.subresourceRange.levelCount = mipLevels;
   viewInfo.subresourceRange.baseArrayLayer = 0;
-  viewInfo.subresourceRange.layerCount = 1;
+  viewInfo.subresourceRange.layerCount = arrayLayers;
 
   if (vkCreateImageView(device->handle(), &viewInfo, nullptr, &view) !=
       VK_SUCCESS) {
     throw std::runtime_error("failed to create texture image view!");
   }
 
-  VkSamplerCreateInfo samplerInfo{};
-  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-  samplerInfo.magFilter = VK_FILTER_LINEAR;
-  samplerInfo.minFilter = VK_FILTER_LINEAR;
-  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  samplerInfo.anisotropyEnable = VK_TRUE;
-
-  VkPhysicalDeviceProperties devProps;
-  vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &devProps);
-  samplerInfo.maxAnisotropy = devProps.limits.maxSamplerAnisotropy;
-  samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-  samplerInfo.unnormalizedCoordinates = VK_FALSE;
-  samplerInfo.compareEnable = VK_FALSE;
-  samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-  samplerInfo.mipLodBias = 0.0f;
-  samplerInfo.minLod = 0.0f;
-  samplerInfo.maxLod = 0.0f;
-
-  if (vkCreateSampler(device->handle(), &samplerInfo, nullptr, &sampler) !=
-      VK_SUCCESS) {
-    throw std::runtime_error("failed to create texture sampler!");
-  }
+  sampler = device->getSamplerCache().get(samplerDesc);
 }
 
 const VkImage &Image::handle() { return textureImage; }
@@ -97,13 +87,23 @@ const VkImageView &Image::getView() { return view; }
 
 const VkSampler &Image::getSampler() { return sampler; }
 
+VkFormat Image::getFormat() { return format; }
+
+VkExtent2D Image::getExtent() { return extent; }
+
+uint32_t Image::getMipLevels() { return mipLevels; }
+
+uint32_t Image::getArrayLayers() { return arrayLayers; }
+
+VkDeviceSize Image::getMemorySize() { return memorySize; }
+
 WriteDescriptorSetWrapper Image::getWriteDescriptorSet(size_t binding) {
   VkDescriptorImageInfo imageInfo{};
   imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
   imageInfo.imageView = view;
   imageInfo.sampler = sampler;
 
-  VkWriteDescriptorSet descriptorWrites;
+  VkWriteDescriptorSet descriptorWrites{};
   descriptorWrites.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
   descriptorWrites.dstBinding = binding;
   descriptorWrites.dstArrayElement = 0;
@@ -114,19 +114,20 @@ WriteDescriptorSetWrapper Image::getWriteDescriptorSet(size_t binding) {
 }
 
 Image::~Image() {
-  vkDestroySampler(device->handle(), sampler, nullptr);
   vkDestroyImageView(device->handle(), view, nullptr);
   vkDestroyImage(device->handle(), textureImage, nullptr);
   vkFreeMemory(device->handle(), textureImageMemory, nullptr);
 }
 
-VkDescriptorSetLayoutBinding Image::getDescriptorSetLayoutBinding(int binding) {
+VkDescriptorSetLayoutBinding
+Image::getDescriptorSetLayoutBinding(int binding,
+                                     const VkSampler *immutableSampler) {
   VkDescriptorSetLayoutBinding samplerLayoutBinding{};
   samplerLayoutBinding.binding = binding;
   samplerLayoutBinding.descriptorCount = 1;
   samplerLayoutBinding.descriptorType =
       VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-  samplerLayoutBinding.pImmutableSamplers = nullptr;
+  samplerLayoutBinding.pImmutableSamplers = immutableSampler;
   samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
   return samplerLayoutBinding;
 }
@@ -135,10 +136,22 @@ void Image::transitionImageLayout(std::shared_ptr<Device> device,
                                   std::shared_ptr<CommandPool> command_pool,
                                   VkImage image, VkFormat format,
                                   VkImageLayout oldLayout,
-                                  VkImageLayout newLayout) {
+                                  VkImageLayout newLayout, uint32_t mipLevels,
+                                  uint32_t arrayLayers) {
   auto cb = createCommandBuffers(device, command_pool, 1);
   cb->begin(0);
 
+  recordLayoutTransition(cb->get(0), image, oldLayout, newLayout, mipLevels,
+                         arrayLayers);
+
+  cb->end(0);
+  cb->submit(0);
+}
+
+void Image::recordLayoutTransition(VkCommandBuffer cb, VkImage image,
+                                   VkImageLayout oldLayout,
+                                   VkImageLayout newLayout,
+                                   uint32_t mipLevels, uint32_t arrayLayers) {
   VkImageMemoryBarrier barrier{};
   barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
   barrier.oldLayout = oldLayout;
@@ -150,9 +163,9 @@ void Image::transitionImageLayout(std::shared_ptr<Device> device,
   barrier.image = image;
   barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
   barrier.subresourceRange.baseMipLevel = 0;
-  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.levelCount = mipLevels;
   barrier.subresourceRange.baseArrayLayer = 0;
-  barrier.subresourceRange.layerCount = 1;
+  barrier.subresourceRange.layerCount = arrayLayers;
 
   VkPipelineStageFlags sourceStage;
   VkPipelineStageFlags destinationStage;
@@ -169,17 +182,35 @@ void Image::transitionImageLayout(std::shared_ptr<Device> device,
     barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
     barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
+    sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  } else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL &&
+             newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  } else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL &&
+             newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL &&
+             newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
     sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
     destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
   } else {
     throw std::invalid_argument("unsupported layout transition!");
   }
 
-  vkCmdPipelineBarrier(cb->get(0), sourceStage, destinationStage, 0, 0, nullptr,
-                       0, nullptr, 1, &barrier);
-
-  cb->end(0);
-  cb->submit(0);
+  vkCmdPipelineBarrier(cb, sourceStage, destinationStage, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
 }
 
 void Image::copyBufferToImage(std::shared_ptr<Device> device,
@@ -187,9 +218,6 @@ void Image::copyBufferToImage(std::shared_ptr<Device> device,
                               std::shared_ptr<Buffer> buffer,
                               std::shared_ptr<Image> image, uint32_t width,
                               uint32_t height) {
-  auto cb = createCommandBuffers(device, command_pool, 1);
-  cb->begin(0);
-
   VkBufferImageCopy region{};
   region.bufferOffset = 0;
   region.bufferRowLength = 0;
@@ -203,8 +231,20 @@ void Image::copyBufferToImage(std::shared_ptr<Device> device,
   region.imageOffset = {0, 0, 0};
   region.imageExtent = {width, height, 1};
 
+  copyBufferToImage(device, command_pool, buffer, image, {region});
+}
+
+void Image::copyBufferToImage(std::shared_ptr<Device> device,
+                              std::shared_ptr<CommandPool> command_pool,
+                              std::shared_ptr<Buffer> buffer,
+                              std::shared_ptr<Image> image,
+                              const std::vector<VkBufferImageCopy> &regions) {
+  auto cb = createCommandBuffers(device, command_pool, 1);
+  cb->begin(0);
+
   vkCmdCopyBufferToImage(cb->get(0), buffer->handle(), image->handle(),
-                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regions.size(),
+                         regions.data());
 
   cb->end(0);
   cb->submit(0);
@@ -212,28 +252,48 @@ void Image::copyBufferToImage(std::shared_ptr<Device> device,
 
 std::shared_ptr<Image> Image::create(std::shared_ptr<Device> device,
                                      std::shared_ptr<CommandPool> command_pool,
-                                     void *img, size_t width, size_t height) {
+                                     void *img, size_t width, size_t height,
+                                     const SamplerDesc &samplerDesc,
+                                     bool generateMipmaps) {
   auto buf = std::make_shared<Buffer>(device, width * height * 4,
                                       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
   buf->fill_from(img);
 
+  VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+  VkImageUsageFlags usage =
+      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  VkImageCreateFlags flags = 0;
+  uint32_t mipLevels = 1;
+  if (generateMipmaps) {
+    usage |= MipmapGenerator::getRequiredUsage(device, format);
+    flags |= MipmapGenerator::getRequiredFlags(device, format);
+    mipLevels = MipmapGenerator::getMipLevels(width, height);
+  }
+
   auto image = std::make_shared<Image>(
-      device, width, height, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
-      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+      device, width, height, format, VK_IMAGE_TILING_OPTIMAL, usage,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mipLevels, 1, flags, samplerDesc);
 
-  transitionImageLayout(device, command_pool, image->handle(),
-                        VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED,
-                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+  transitionImageLayout(device, command_pool, image->handle(), format,
+                        VK_IMAGE_LAYOUT_UNDEFINED,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
 
   copyBufferToImage(device, command_pool, buf, image, width, height);
 
-  transitionImageLayout(device, command_pool, image->handle(),
-                        VK_FORMAT_R8G8B8A8_SRGB,
-                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  if (generateMipmaps) {
+    auto generator = createMipmapGenerator(device);
+    auto cb = createCommandBuffers(device, command_pool, 1);
+    cb->begin(0);
+    generator->record(cb->get(0), image);
+    cb->end(0);
+    cb->submit(0);
+  } else {
+    transitionImageLayout(device, command_pool, image->handle(), format,
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  }
 
   return image;
 }
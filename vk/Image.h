@@ -1,7 +1,9 @@
 #pragma once
 
+#include "SamplerCache.h"
 #include "WriteDescriptorSetWrapper.h"
 #include <memory>
+#include <vector>
 #include <vulkan/vulkan.h>
 namespace toffoo::vk {
 class Device;
@@ -13,28 +15,53 @@ private:
   VkImage textureImage;
   VkDeviceMemory textureImageMemory;
   VkImageView view;
+  // Owned by the sampler cache of the device
   VkSampler sampler;
 
+  VkFormat format;
+  VkExtent2D extent;
+  uint32_t mipLevels;
+  uint32_t arrayLayers;
+  VkDeviceSize memorySize;
+
   std::shared_ptr<Device> device;
 
 public:
   Image(std::shared_ptr<Device> device, size_t width, size_t height,
         VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-        VkMemoryPropertyFlags properties);
+        VkMemoryPropertyFlags properties, uint32_t mipLevels = 1,
+        uint32_t arrayLayers = 1, VkImageCreateFlags flags = 0,
+        const SamplerDesc &samplerDesc = {});
 
   const VkImage &handle();
   const VkImageView &getView();
   const VkSampler &getSampler();
 
+  VkFormat getFormat();
+  VkExtent2D getExtent();
+  uint32_t getMipLevels();
+  // Images with more than one layer get a VK_IMAGE_VIEW_TYPE_2D_ARRAY view
+  uint32_t getArrayLayers();
+  // Size of the dedicated allocation backing the image
+  VkDeviceSize getMemorySize();
+
   WriteDescriptorSetWrapper getWriteDescriptorSet(size_t binding);
 
   virtual ~Image();
 
+  static void recordLayoutTransition(VkCommandBuffer cb, VkImage image,
+                                     VkImageLayout oldLayout,
+                                     VkImageLayout newLayout,
+                                     uint32_t mipLevels = 1,
+                                     uint32_t arrayLayers = 1);
+
   static void transitionImageLayout(std::shared_ptr<Device> device,
                                     std::shared_ptr<CommandPool> command_pool,
                                     VkImage image, VkFormat format,
                                     VkImageLayout oldLayout,
-                                    VkImageLayout newLayout);
+                                    VkImageLayout newLayout,
+                                    uint32_t mipLevels = 1,
+                                    uint32_t arrayLayers = 1);
 
   static void copyBufferToImage(std::shared_ptr<Device> device,
                                 std::shared_ptr<CommandPool> command_pool,
@@ -42,12 +69,23 @@ public:
                                 std::shared_ptr<Image> image, uint32_t width,
                                 uint32_t height);
 
+  static void copyBufferToImage(std::shared_ptr<Device> device,
+                                std::shared_ptr<CommandPool> command_pool,
+                                std::shared_ptr<Buffer> buffer,
+                                std::shared_ptr<Image> image,
+                                const std::vector<VkBufferImageCopy> &regions);
+
+  // Pass a sampler from SamplerCache::get to bake it into the layout as an
+  // immutable sampler
   static VkDescriptorSetLayoutBinding
-  getDescriptorSetLayoutBinding(int binding);
+  getDescriptorSetLayoutBinding(int binding,
+                                const VkSampler *immutableSampler = nullptr);
 
+  // With generateMipmaps the image gets a full mip chain filled on the GPU
   static std::shared_ptr<Image>
   create(std::shared_ptr<Device> device,
          std::shared_ptr<CommandPool> command_pool, void *img, size_t width,
-         size_t height);
+         size_t height, const SamplerDesc &samplerDesc = {},
+         bool generateMipmaps = false);
 };
 } // namespace toffoo::vk
\ No newline at end of file
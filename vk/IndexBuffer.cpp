@@ -1,13 +1,94 @@
 #include "IndexBuffer.h"
+#include "Device.h"
+#include <stdexcept>
 
 namespace toffoo::vk {
-IndexBuffer::IndexBuffer(std::shared_ptr<Device> device, size_t size)
+IndexBuffer::IndexBuffer(std::shared_ptr<Device> device, size_t size,
+                         VkIndexType indexType)
     : Buffer(device, size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {}
+                 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+      indexType(indexType) {}
+
+VkIndexType IndexBuffer::getIndexType() { return indexType; }
+
+uint32_t IndexBuffer::getIndexCount() {
+  return bufferSize / getIndexSize(indexType);
+}
+
+size_t IndexBuffer::getIndexSize(VkIndexType indexType) {
+  switch (indexType) {
+  case VK_INDEX_TYPE_UINT8_EXT:
+    return 1;
+  case VK_INDEX_TYPE_UINT16:
+    return 2;
+  case VK_INDEX_TYPE_UINT32:
+    return 4;
+  default:
+    throw std::invalid_argument("unsupported index type!");
+  }
+}
+
+VkIndexType IndexBuffer::getCompactIndexType(Device &device,
+                                             size_t vertexCount) {
+  if (vertexCount <= UINT8_MAX + 1 &&
+      device.isExtensionEnabled(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME)) {
+    return VK_INDEX_TYPE_UINT8_EXT;
+  }
+  if (vertexCount <= UINT16_MAX + 1) {
+    return VK_INDEX_TYPE_UINT16;
+  }
+  if (vertexCount - 1 >
+      device.getProperties().limits.maxDrawIndexedIndexValue) {
+    throw std::runtime_error("mesh has too many vertices for the device!");
+  }
+  return VK_INDEX_TYPE_UINT32;
+}
+
+template <typename T>
+static void narrow(const std::vector<uint32_t> &indices, void *dst) {
+  T *out = static_cast<T *>(dst);
+  for (size_t i = 0; i < indices.size(); i++) {
+    out[i] = (T)indices[i];
+  }
+}
+
+void IndexBuffer::write(uint32_t firstIndex,
+                        const std::vector<uint32_t> &indices) {
+  if (firstIndex + indices.size() > getIndexCount()) {
+    throw std::out_of_range("indices do not fit into the index buffer!");
+  }
+
+  char *dst = static_cast<char *>(map()) + firstIndex * getIndexSize(indexType);
+  switch (indexType) {
+  case VK_INDEX_TYPE_UINT8_EXT:
+    narrow<uint8_t>(indices, dst);
+    break;
+  case VK_INDEX_TYPE_UINT16:
+    narrow<uint16_t>(indices, dst);
+    break;
+  default:
+    narrow<uint32_t>(indices, dst);
+    break;
+  }
+}
 
 std::shared_ptr<IndexBuffer> createIndexBuffer(std::shared_ptr<Device> device,
-                                               size_t size) {
-  return std::make_shared<IndexBuffer>(device, size);
+                                               size_t size,
+                                               VkIndexType indexType) {
+  return std::make_shared<IndexBuffer>(device, size, indexType);
+}
+
+std::shared_ptr<IndexBuffer>
+createIndexBuffer(std::shared_ptr<Device> device,
+                  const std::vector<uint32_t> &indices, size_t vertexCount) {
+  VkIndexType indexType =
+      IndexBuffer::getCompactIndexType(*device, vertexCount);
+  auto buffer = std::make_shared<IndexBuffer>(
+      device, indices.size() * IndexBuffer::getIndexSize(indexType),
+      indexType);
+
+  buffer->write(0, indices);
+  return buffer;
 }
 } // namespace toffoo::vk
\ No newline at end of file
@@ -1,14 +1,39 @@
 #pragma once
 #include "Buffer.h"
+#include <cstdint>
 #include <memory>
+#include <vector>
 #include <vulkan/vulkan.h>
 
 namespace toffoo::vk {
 class IndexBuffer : public Buffer {
+private:
+  VkIndexType indexType;
+
 public:
-  IndexBuffer(std::shared_ptr<Device> device, size_t size);
+  IndexBuffer(std::shared_ptr<Device> device, size_t size,
+              VkIndexType indexType = VK_INDEX_TYPE_UINT16);
+
+  VkIndexType getIndexType();
+
+  uint32_t getIndexCount();
+
+  // Narrows the indices to the index type, values must fit
+  void write(uint32_t firstIndex, const std::vector<uint32_t> &indices);
+
+  static size_t getIndexSize(VkIndexType indexType);
+
+  // Smallest type addressing vertexCount vertices, 8-bit indices need
+  // VK_EXT_index_type_uint8
+  static VkIndexType getCompactIndexType(Device &device, size_t vertexCount);
 };
 
-std::shared_ptr<IndexBuffer> createIndexBuffer(std::shared_ptr<Device> device,
-                                               size_t size);
+std::shared_ptr<IndexBuffer>
+createIndexBuffer(std::shared_ptr<Device> device, size_t size,
+                  VkIndexType indexType = VK_INDEX_TYPE_UINT16);
+
+// Narrows the indices to getCompactIndexType() and uploads them
+std::shared_ptr<IndexBuffer>
+createIndexBuffer(std::shared_ptr<Device> device,
+                  const std::vector<uint32_t> &indices, size_t vertexCount);
 } // namespace toffoo::vk
\ No newline at end of file
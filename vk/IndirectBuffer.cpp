@@ -0,0 +1,42 @@
+#include "IndirectBuffer.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace toffoo::vk {
+IndirectBuffer::IndirectBuffer(std::shared_ptr<Device> device,
+                               uint32_t capacity)
+    : StorageBuffer(device,
+                    commandsOffset +
+                        capacity * sizeof(VkDrawIndexedIndirectCommand),
+                    VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                        VK_BUFFER_USAGE_TRANSFER_DST_BIT),
+      capacity(capacity) {
+  memset(map(), 0, bufferSize);
+}
+
+uint32_t IndirectBuffer::getCapacity() { return capacity; }
+
+uint32_t IndirectBuffer::getDrawCount() {
+  return *static_cast<uint32_t *>(map());
+}
+
+VkDrawIndexedIndirectCommand *IndirectBuffer::getCommands() {
+  return reinterpret_cast<VkDrawIndexedIndirectCommand *>(
+      static_cast<char *>(map()) + commandsOffset);
+}
+
+void IndirectBuffer::write(
+    const std::vector<VkDrawIndexedIndirectCommand> &commands) {
+  if (commands.size() > capacity) {
+    throw std::out_of_range("too many draws for the indirect buffer!");
+  }
+  memcpy(getCommands(), commands.data(),
+         commands.size() * sizeof(VkDrawIndexedIndirectCommand));
+  *static_cast<uint32_t *>(map()) = commands.size();
+}
+
+std::shared_ptr<IndirectBuffer>
+createIndirectBuffer(std::shared_ptr<Device> device, uint32_t capacity) {
+  return std::make_shared<IndirectBuffer>(device, capacity);
+}
+} // namespace toffoo::vk
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "StorageBuffer.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+
+// Draw count followed by VkDrawIndexedIndirectCommand records, written by the
+// CPU or by a compute shader bound as a storage buffer. The count is only
+// read by the GPU when VK_KHR_draw_indirect_count is available, see
+// CommandBuffers::drawIndexedIndirect.
+class IndirectBuffer : public StorageBuffer {
+private:
+  uint32_t capacity;
+
+public:
+  // Keeps the count in its own 16 byte slot for std430 layouts
+  static const VkDeviceSize commandsOffset = 16;
+
+  IndirectBuffer(std::shared_ptr<Device> device, uint32_t capacity);
+
+  uint32_t getCapacity();
+
+  uint32_t getDrawCount();
+
+  VkDrawIndexedIndirectCommand *getCommands();
+
+  // Replaces the draws and the count
+  void write(const std::vector<VkDrawIndexedIndirectCommand> &commands);
+};
+
+std::shared_ptr<IndirectBuffer>
+createIndirectBuffer(std::shared_ptr<Device> device, uint32_t capacity);
+} // namespace toffoo::vk
\ No newline at end of file
@@ -21,7 +21,7 @@ Instance::Instance(const std::vector<const char *> &extensions,
       .applicationVersion = VK_MAKE_VERSION(0, 1, 0),
       .pEngineName = "Toffoo Engine",
       .engineVersion = VK_MAKE_VERSION(0, 1, 0),
-      .apiVersion = VK_API_VERSION_1_0,
+      .apiVersion = VK_API_VERSION_1_2,
   };
   VkInstanceCreateInfo createInfo{
       .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
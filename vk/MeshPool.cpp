@@ -0,0 +1,93 @@
+#include "MeshPool.h"
+#include "IndexBuffer.h"
+#include "VertexBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace toffoo::vk {
+VkDrawIndexedIndirectCommand
+MeshRange::getDrawCommand(uint32_t instanceCount,
+                          uint32_t firstInstance) const {
+  return {.indexCount = indexCount,
+          .instanceCount = instanceCount,
+          .firstIndex = firstIndex,
+          .vertexOffset = vertexOffset,
+          .firstInstance = firstInstance};
+}
+
+MeshPool::MeshPool(std::shared_ptr<Device> device, uint32_t vertexStride,
+                   uint32_t maxVertices, uint32_t maxIndices,
+                   VkIndexType indexType)
+    : vertexStride(vertexStride) {
+  vertexBuffer = createVertexBuffer(device, (size_t)maxVertices * vertexStride);
+  indexBuffer = createIndexBuffer(
+      device, maxIndices * IndexBuffer::getIndexSize(indexType), indexType);
+}
+
+MeshRange MeshPool::add(std::span<const char> vertices,
+                        const std::vector<uint32_t> &indices) {
+  return add(vertices, std::vector<std::vector<uint32_t>>{indices}).front();
+}
+
+std::vector<MeshRange>
+MeshPool::add(std::span<const char> vertices,
+              const std::vector<std::vector<uint32_t>> &lodIndices) {
+  if (vertices.size() % vertexStride != 0) {
+    throw std::invalid_argument("vertex data does not match the stride!");
+  }
+  uint32_t count = vertices.size() / vertexStride;
+  size_t totalIndices = 0;
+  uint32_t maxIndex = 0;
+  for (const auto &indices : lodIndices) {
+    totalIndices += indices.size();
+    for (uint32_t index : indices) {
+      maxIndex = std::max(maxIndex, index);
+    }
+  }
+  if (totalIndices > 0 && maxIndex >= count) {
+    throw std::invalid_argument("index outside of the mesh vertices!");
+  }
+  // Indices are stored relative to the mesh and the draw adds vertexOffset
+  // after fetching them, so only the vertices of this mesh need to be
+  // addressable with the index type
+  size_t indexSize = IndexBuffer::getIndexSize(indexBuffer->getIndexType());
+  if (indexSize < sizeof(uint32_t) && count > (1ull << (indexSize * 8))) {
+    throw std::runtime_error("mesh does not fit the pool index type!");
+  }
+  if ((size_t)(vertexCount + count) * vertexStride > vertexBuffer->size() ||
+      indexCount + totalIndices > indexBuffer->getIndexCount()) {
+    throw std::runtime_error("mesh pool is full!");
+  }
+
+  memcpy(static_cast<char *>(vertexBuffer->map()) +
+             (size_t)vertexCount * vertexStride,
+         vertices.data(), vertices.size());
+
+  std::vector<MeshRange> ranges;
+  for (const auto &indices : lodIndices) {
+    ranges.push_back({.firstIndex = indexCount,
+                      .indexCount = (uint32_t)indices.size(),
+                      .vertexOffset = (int32_t)vertexCount});
+    indexBuffer->write(indexCount, indices);
+    indexCount += indices.size();
+  }
+  vertexCount += count;
+  return ranges;
+}
+
+std::shared_ptr<VertexBuffer> MeshPool::getVertexBuffer() {
+  return vertexBuffer;
+}
+
+std::shared_ptr<IndexBuffer> MeshPool::getIndexBuffer() { return indexBuffer; }
+
+std::shared_ptr<MeshPool> createMeshPool(std::shared_ptr<Device> device,
+                                         uint32_t vertexStride,
+                                         uint32_t maxVertices,
+                                         uint32_t maxIndices,
+                                         VkIndexType indexType) {
+  return std::make_shared<MeshPool>(device, vertexStride, maxVertices,
+                                    maxIndices, indexType);
+}
+} // namespace toffoo::vk
\ No newline at end of file
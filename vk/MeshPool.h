@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class VertexBuffer;
+class IndexBuffer;
+
+// Where a mesh lives inside a MeshPool
+struct MeshRange {
+  uint32_t firstIndex;
+  uint32_t indexCount;
+  int32_t vertexOffset;
+
+  VkDrawIndexedIndirectCommand getDrawCommand(uint32_t instanceCount = 1,
+                                              uint32_t firstInstance = 0) const;
+};
+
+// Meshes of one vertex layout packed into a shared vertex and index buffer, so
+// they can all be drawn with a single bind and one indirect draw call.
+// Allocation is linear, meshes are never freed.
+class MeshPool {
+private:
+  std::shared_ptr<VertexBuffer> vertexBuffer;
+  std::shared_ptr<IndexBuffer> indexBuffer;
+
+  uint32_t vertexStride;
+  uint32_t vertexCount = 0;
+  uint32_t indexCount = 0;
+
+public:
+  MeshPool(std::shared_ptr<Device> device, uint32_t vertexStride,
+           uint32_t maxVertices, uint32_t maxIndices,
+           VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+
+  // Indices are relative to the first vertex of the mesh. Throws when the mesh
+  // has more vertices than the index type of the pool can address.
+  MeshRange add(std::span<const char> vertices,
+                const std::vector<uint32_t> &indices);
+
+  // Levels of detail sharing the vertices, one range per level with the index
+  // ranges following each other
+  std::vector<MeshRange>
+  add(std::span<const char> vertices,
+      const std::vector<std::vector<uint32_t>> &lodIndices);
+
+  std::shared_ptr<VertexBuffer> getVertexBuffer();
+
+  std::shared_ptr<IndexBuffer> getIndexBuffer();
+};
+
+std::shared_ptr<MeshPool>
+createMeshPool(std::shared_ptr<Device> device, uint32_t vertexStride,
+               uint32_t maxVertices, uint32_t maxIndices,
+               VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+} // namespace toffoo::vk
\ No newline at end of file
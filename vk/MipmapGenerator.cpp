@@ -0,0 +1,286 @@
+#include "MipmapGenerator.h"
+#include "DescriptorAllocator.h"
+#include "Device.h"
+#include "Image.h"
+#include "Pipeline.h"
+#include "Shader.h"
+#include "Utils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace toffoo::vk {
+// mipmap.comp writes rgba8 storage images, sRGB levels are aliased as UNORM
+static VkFormat getStorageFormat(VkFormat format) {
+  switch (format) {
+  case VK_FORMAT_R8G8B8A8_SRGB:
+    return VK_FORMAT_R8G8B8A8_UNORM;
+  default:
+    return format;
+  }
+}
+
+// Stages that may sample the finished chain
+static const VkPipelineStageFlags readStages =
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+static bool canCompute(std::shared_ptr<Device> device, VkFormat format) {
+  VkFormat storageFormat = getStorageFormat(format);
+  if (storageFormat != VK_FORMAT_R8G8B8A8_UNORM) {
+    return false;
+  }
+
+  VkFormatProperties props;
+  vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice(),
+                                      storageFormat, &props);
+  return props.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+}
+
+MipmapGenerator::MipmapGenerator(std::shared_ptr<Device> device)
+    : device(device) {}
+
+uint32_t MipmapGenerator::getMipLevels(uint32_t width, uint32_t height) {
+  return (uint32_t)std::floor(std::log2(std::max(width, height))) + 1;
+}
+
+bool MipmapGenerator::canBlit(std::shared_ptr<Device> device,
+                              VkFormat format) {
+  VkFormatFeatureFlags required =
+      VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+      VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+  VkFormatProperties props;
+  vkGetPhysicalDeviceFormatProperties(device->getPhysicalDevice(), format,
+                                      &props);
+  return (props.optimalTilingFeatures & required) == required;
+}
+
+VkImageUsageFlags
+MipmapGenerator::getRequiredUsage(std::shared_ptr<Device> device,
+                                  VkFormat format) {
+  if (canBlit(device, format)) {
+    return VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  }
+  if (canCompute(device, format)) {
+    return VK_IMAGE_USAGE_STORAGE_BIT;
+  }
+  throw std::runtime_error("mipmap generation is not supported for format!");
+}
+
+VkImageCreateFlags
+MipmapGenerator::getRequiredFlags(std::shared_ptr<Device> device,
+                                  VkFormat format) {
+  if (canBlit(device, format) || getStorageFormat(format) == format) {
+    return 0;
+  }
+  return VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT |
+         VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+}
+
+void MipmapGenerator::record(VkCommandBuffer cb, std::shared_ptr<Image> image) {
+  if (canBlit(device, image->getFormat())) {
+    recordBlit(cb, image);
+  } else {
+    recordCompute(cb, image);
+  }
+}
+
+void MipmapGenerator::recordBlit(VkCommandBuffer cb,
+                                 std::shared_ptr<Image> image) {
+  VkImageMemoryBarrier barrier{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image->handle(),
+      .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                           .levelCount = 1,
+                           .layerCount = image->getArrayLayers()}};
+
+  int32_t width = image->getExtent().width;
+  int32_t height = image->getExtent().height;
+
+  for (uint32_t i = 1; i < image->getMipLevels(); i++) {
+    barrier.subresourceRange.baseMipLevel = i - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &barrier);
+
+    int32_t levelWidth = std::max(width / 2, 1);
+    int32_t levelHeight = std::max(height / 2, 1);
+
+    VkImageBlit blit{
+        .srcSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                           .mipLevel = i - 1,
+                           .layerCount = image->getArrayLayers()},
+        .srcOffsets = {{0, 0, 0}, {width, height, 1}},
+        .dstSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                           .mipLevel = i,
+                           .layerCount = image->getArrayLayers()},
+        .dstOffsets = {{0, 0, 0}, {levelWidth, levelHeight, 1}}};
+    vkCmdBlitImage(cb, image->handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   image->handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                   &blit, VK_FILTER_LINEAR);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TRANSFER_BIT, readStages, 0, 0,
+                         nullptr, 0, nullptr, 1, &barrier);
+
+    width = levelWidth;
+    height = levelHeight;
+  }
+
+  barrier.subresourceRange.baseMipLevel = image->getMipLevels() - 1;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TRANSFER_BIT, readStages, 0, 0,
+                       nullptr, 0, nullptr, 1, &barrier);
+}
+
+void MipmapGenerator::recordCompute(VkCommandBuffer cb,
+                                    std::shared_ptr<Image> image) {
+  if (device->getDescriptorBackend() != DescriptorBackend::Sets) {
+    throw std::runtime_error(
+        "compute mipmap generation requires the descriptor set backend!");
+  }
+  if (image->getArrayLayers() > 1) {
+    throw std::runtime_error(
+        "compute mipmap generation does not support array images!");
+  }
+
+  if (!pipeline) {
+    ComputePipelineBuilder builder(device);
+    builder.addComputeShader(createShader(device, "mipmap.spv"));
+    for (int binding : {0, 1}) {
+      builder.addDescritorSetLayoutBinding(
+          {.binding = (uint32_t)binding,
+           .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+           .descriptorCount = 1,
+           .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT});
+    }
+    builder.addPushConstantRange({VK_SHADER_STAGE_COMPUTE_BIT, 0, 4});
+    pipeline = builder.build();
+
+    descriptorAllocator = createDescriptorAllocator(device, 1);
+  }
+
+  uint32_t levels = image->getMipLevels();
+  VkFormat storageFormat = getStorageFormat(image->getFormat());
+
+  for (uint32_t i = 0; i < levels; i++) {
+    VkImageViewCreateInfo viewInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = image->handle(),
+        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .format = storageFormat,
+        .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                             .baseMipLevel = i,
+                             .levelCount = 1,
+                             .layerCount = 1}};
+
+    VkImageView view;
+    VK_THROW_NOT_OK(
+        vkCreateImageView(device->handle(), &viewInfo, nullptr, &view));
+    levelViews.push_back(view);
+  }
+  VkImageView *views = levelViews.data() + levelViews.size() - levels;
+
+  VkImageMemoryBarrier barrier{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+      .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image->handle(),
+      .subresourceRange = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                           .levelCount = levels,
+                           .layerCount = 1}};
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->handle());
+
+  uint32_t srgb = storageFormat != image->getFormat();
+  vkCmdPushConstants(cb, pipeline->getLayout()->handle(),
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(srgb), &srgb);
+
+  uint32_t width = image->getExtent().width;
+  uint32_t height = image->getExtent().height;
+
+  for (uint32_t i = 1; i < levels; i++) {
+    width = std::max(width / 2, 1u);
+    height = std::max(height / 2, 1u);
+
+    std::vector<WriteDescriptorSetWrapper> writes;
+    for (uint32_t binding : {0u, 1u}) {
+      VkWriteDescriptorSet write{
+          .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+          .dstBinding = binding,
+          .dstArrayElement = 0,
+          .descriptorCount = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE};
+      VkDescriptorImageInfo imageInfo{.imageView = views[i - 1 + binding],
+                                      .imageLayout = VK_IMAGE_LAYOUT_GENERAL};
+      writes.emplace_back(write, imageInfo);
+    }
+
+    VkDescriptorSet set = descriptorAllocator->allocate(
+        pipeline->getDescriptorSetLayout(), writes);
+    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                            pipeline->getLayout()->handle(), 0, 1, &set, 0,
+                            nullptr);
+
+    vkCmdDispatch(cb, (width + 7) / 8, (height + 7) / 8, 1);
+
+    // The next level reads what this one wrote
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.subresourceRange.baseMipLevel = i;
+    barrier.subresourceRange.levelCount = 1;
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &barrier);
+  }
+
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = levels;
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, readStages, 0,
+                       0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void MipmapGenerator::reset() {
+  for (auto view : levelViews) {
+    vkDestroyImageView(device->handle(), view, nullptr);
+  }
+  levelViews.clear();
+
+  if (descriptorAllocator) {
+    descriptorAllocator->beginFrame(0);
+  }
+}
+
+MipmapGenerator::~MipmapGenerator() { reset(); }
+
+std::shared_ptr<MipmapGenerator>
+createMipmapGenerator(std::shared_ptr<Device> device) {
+  return std::make_shared<MipmapGenerator>(device);
+}
+} // namespace toffoo::vk
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class Image;
+class ComputePipeline;
+class DescriptorAllocator;
+
+// Fills mip levels 1..N from level 0. Uses a chain of linear blits when the
+// format supports it and a compute downsample (mipmap.spv) otherwise.
+class MipmapGenerator {
+private:
+  std::shared_ptr<Device> device;
+
+  std::shared_ptr<ComputePipeline> pipeline;
+  std::shared_ptr<DescriptorAllocator> descriptorAllocator;
+  std::vector<VkImageView> levelViews;
+
+  void recordBlit(VkCommandBuffer cb, std::shared_ptr<Image> image);
+
+  void recordCompute(VkCommandBuffer cb, std::shared_ptr<Image> image);
+
+public:
+  MipmapGenerator(std::shared_ptr<Device> device);
+
+  static uint32_t getMipLevels(uint32_t width, uint32_t height);
+
+  static bool canBlit(std::shared_ptr<Device> device, VkFormat format);
+
+  // Usage and create flags an image of this format needs to get its mips
+  // generated
+  static VkImageUsageFlags getRequiredUsage(std::shared_ptr<Device> device,
+                                            VkFormat format);
+  static VkImageCreateFlags getRequiredFlags(std::shared_ptr<Device> device,
+                                             VkFormat format);
+
+  // All levels must be in TRANSFER_DST_OPTIMAL with level 0 filled, the whole
+  // chain ends up in SHADER_READ_ONLY_OPTIMAL, visible to vertex, fragment and
+  // compute shaders
+  void record(VkCommandBuffer cb, std::shared_ptr<Image> image);
+
+  // Releases the per-level views and descriptor sets once the recorded
+  // commands have finished executing
+  void reset();
+
+  ~MipmapGenerator();
+};
+
+std::shared_ptr<MipmapGenerator>
+createMipmapGenerator(std::shared_ptr<Device> device);
+} // namespace toffoo::vk
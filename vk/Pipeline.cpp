@@ -1,25 +1,67 @@
 #include "Pipeline.h"
 #include "Device.h"
+#include "PipelineLibrary.h"
 #include "RenderPass.h"
 #include "Shader.h"
 #include "SwapChain.h"
 #include "Utils.h"
+#include <array>
 
 namespace toffoo::vk {
 
-GraphicsPipeline::GraphicsPipeline(GraphicsPipelineBuilder &builder)
-    : device(builder.device), renderPass(builder.renderPass) {
-  VkPipelineShaderStageCreateInfo shaders[2] = {builder.vertShaderStageInfo,
-                                                builder.fragShaderStageInfo};
+Pipeline::Pipeline(std::shared_ptr<Device> device) : device(device) {}
+
+VkPipeline Pipeline::handle() { return pipeline; }
+
+VkPipelineCreateFlags Pipeline::getCreateFlags() {
+  if (pipelineLayout->isDescriptorBuffer()) {
+    return VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+  }
+  return 0;
+}
+
+std::shared_ptr<PipelineLayout> Pipeline::getLayout() { return pipelineLayout; }
 
+std::shared_ptr<DescriptorSetLayout> Pipeline::getDescriptorSetLayout() {
+  return descriptorSetLayout;
+}
+
+Pipeline::~Pipeline() {
+  vkDestroyPipeline(device->handle(), pipeline, nullptr);
+}
+
+GraphicsPipeline::GraphicsPipeline(GraphicsPipelineBuilder &builder)
+    : Pipeline(builder.device), renderPass(builder.renderPass) {
   descriptorSetLayout = std::make_shared<DescriptorSetLayout>(
-      device, builder.descriptorSetLayoutBindings);
+      device, builder.descriptorSetLayoutBindings,
+      builder.descriptorSetLayoutFlags);
+
+  std::vector<std::shared_ptr<DescriptorSetLayout>> setLayouts = {
+      descriptorSetLayout};
+  setLayouts.insert(setLayouts.end(), builder.extraSetLayouts.begin(),
+                    builder.extraSetLayouts.end());
+
+  pipelineLayout = std::make_shared<PipelineLayout>(device, setLayouts,
+                                                    builder.pushConstantRanges);
+
+  builder.vertexInputStateInfo.pVertexBindingDescriptions =
+      builder.vertexBindingDescriptions.data();
+  builder.vertexInputStateInfo.pVertexAttributeDescriptions =
+      builder.vertexAttributeDescriptions.data();
+
+  if (builder.libraryCache &&
+      device->isExtensionEnabled(
+          VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+    linkLibraries(builder);
+    return;
+  }
 
-  pipelineLayout =
-      std::make_shared<PipelineLayout>(device, descriptorSetLayout);
+  VkPipelineShaderStageCreateInfo shaders[2] = {builder.vertShaderStageInfo,
+                                                builder.fragShaderStageInfo};
 
   VkGraphicsPipelineCreateInfo pipelineInfo{
       .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+      .flags = getCreateFlags(),
       .stageCount = 2,
       .pStages = shaders,
       .pVertexInputState = &builder.vertexInputStateInfo,
@@ -40,19 +82,113 @@ GraphicsPipeline::GraphicsPipeline(GraphicsPipelineBuilder &builder)
                                             &pipelineInfo, nullptr, &pipeline));
 }
 
-VkPipeline GraphicsPipeline::handle() { return pipeline; }
+void GraphicsPipeline::linkLibraries(GraphicsPipelineBuilder &builder) {
+  auto &cache = builder.libraryCache;
+
+  VkGraphicsPipelineCreateInfo vertexInputInfo{
+      .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+      .flags = getCreateFlags(),
+      .pVertexInputState = &builder.vertexInputStateInfo,
+      .pInputAssemblyState = &builder.inputAssemblyStateInfo};
+
+  VkGraphicsPipelineCreateInfo preRasterizationInfo{
+      .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+      .flags = getCreateFlags(),
+      .stageCount = 1,
+      .pStages = &builder.vertShaderStageInfo,
+      .pViewportState = &builder.viewportStateInfo,
+      .pRasterizationState = &builder.rasterizerStateInfo,
+      .layout = pipelineLayout->handle(),
+      .renderPass = renderPass->handle(),
+      .subpass = 0};
+
+  VkGraphicsPipelineCreateInfo fragmentShaderInfo{
+      .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+      .flags = getCreateFlags(),
+      .stageCount = 1,
+      .pStages = &builder.fragShaderStageInfo,
+      .pMultisampleState = &builder.miltisamplingStateInfo,
+      .pDepthStencilState = nullptr,
+      .layout = pipelineLayout->handle(),
+      .renderPass = renderPass->handle(),
+      .subpass = 0};
+
+  VkGraphicsPipelineCreateInfo fragmentOutputInfo{
+      .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+      .flags = getCreateFlags(),
+      .pMultisampleState = &builder.miltisamplingStateInfo,
+      .pColorBlendState = &builder.colorBlendingStateInfo,
+      .renderPass = renderPass->handle(),
+      .subpass = 0};
+
+  std::array<VkPipeline, 4> libraries = {
+      cache->getOrCreate(
+          builder.getVertexInputKey(),
+          VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+          vertexInputInfo, {}),
+      cache->getOrCreate(
+          builder.getPreRasterizationKey(),
+          VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+          preRasterizationInfo,
+          {pipelineLayout, {builder.vertShader}, renderPass}),
+      cache->getOrCreate(builder.getFragmentShaderKey(),
+                         VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+                         fragmentShaderInfo,
+                         {pipelineLayout, {builder.fragShader}, renderPass}),
+      cache->getOrCreate(
+          builder.getFragmentOutputKey(),
+          VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT,
+          fragmentOutputInfo, {nullptr, {}, renderPass})};
+
+  VkPipelineLibraryCreateInfoKHR libraryInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+      .libraryCount = (uint32_t)libraries.size(),
+      .pLibraries = libraries.data()};
 
-std::shared_ptr<PipelineLayout> GraphicsPipeline::getLayout() {
-  return pipelineLayout;
+  VkGraphicsPipelineCreateInfo pipelineInfo{
+      .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+      .pNext = &libraryInfo,
+      .flags = getCreateFlags(),
+      .layout = pipelineLayout->handle(),
+      .basePipelineHandle = VK_NULL_HANDLE,
+      .basePipelineIndex = -1};
+
+  VK_THROW_NOT_OK(vkCreateGraphicsPipelines(device->handle(), VK_NULL_HANDLE, 1,
+                                            &pipelineInfo, nullptr, &pipeline));
 }
 
-std::shared_ptr<DescriptorSetLayout>
-GraphicsPipeline::getDescriptorSetLayout() {
-  return descriptorSetLayout;
+VkPipelineBindPoint GraphicsPipeline::getBindPoint() {
+  return VK_PIPELINE_BIND_POINT_GRAPHICS;
 }
 
-GraphicsPipeline::~GraphicsPipeline() {
-  vkDestroyPipeline(device->handle(), pipeline, nullptr);
+ComputePipeline::ComputePipeline(ComputePipelineBuilder &builder)
+    : Pipeline(builder.device), shader(builder.shader) {
+  descriptorSetLayout = std::make_shared<DescriptorSetLayout>(
+      device, builder.descriptorSetLayoutBindings,
+      builder.descriptorSetLayoutFlags);
+
+  std::vector<std::shared_ptr<DescriptorSetLayout>> setLayouts = {
+      descriptorSetLayout};
+  setLayouts.insert(setLayouts.end(), builder.extraSetLayouts.begin(),
+                    builder.extraSetLayouts.end());
+
+  pipelineLayout = std::make_shared<PipelineLayout>(device, setLayouts,
+                                                    builder.pushConstantRanges);
+
+  VkComputePipelineCreateInfo pipelineInfo{
+      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+      .flags = getCreateFlags(),
+      .stage = builder.shaderStageInfo,
+      .layout = pipelineLayout->handle(),
+      .basePipelineHandle = VK_NULL_HANDLE,
+      .basePipelineIndex = -1};
+
+  VK_THROW_NOT_OK(vkCreateComputePipelines(device->handle(), VK_NULL_HANDLE, 1,
+                                           &pipelineInfo, nullptr, &pipeline));
+}
+
+VkPipelineBindPoint ComputePipeline::getBindPoint() {
+  return VK_PIPELINE_BIND_POINT_COMPUTE;
 }
 
 GraphicsPipelineBuilder::GraphicsPipelineBuilder(
@@ -79,15 +215,35 @@ void GraphicsPipelineBuilder::addFragmentShader(
 }
 
 void GraphicsPipelineBuilder::addVertexInputState(
-    const std::vector<VkVertexInputAttributeDescription> &attributeDescriptions,
+    std::span<const VkVertexInputAttributeDescription> attributeDescriptions,
     const VkVertexInputBindingDescription &bindingDescription) {
+  setVertexInputState(attributeDescriptions, {&bindingDescription, 1}, 0);
+}
+
+void GraphicsPipelineBuilder::addVertexInputState(
+    std::span<const VkVertexInputAttributeDescription> attributeDescriptions,
+    std::span<const VkVertexInputBindingDescription> bindingDescriptions) {
+  setVertexInputState(attributeDescriptions, bindingDescriptions, 0);
+}
+
+// layoutHash comes from VertexLayout::getHash, 0 leaves the hashing to
+// getVertexInputKey
+void GraphicsPipelineBuilder::setVertexInputState(
+    std::span<const VkVertexInputAttributeDescription> attributeDescriptions,
+    std::span<const VkVertexInputBindingDescription> bindingDescriptions,
+    size_t layoutHash) {
+  vertexBindingDescriptions.assign(bindingDescriptions.begin(),
+                                   bindingDescriptions.end());
+  vertexAttributeDescriptions.assign(attributeDescriptions.begin(),
+                                     attributeDescriptions.end());
+  vertexLayoutHash = layoutHash;
+
   vertexInputStateInfo = {
       .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-      .vertexBindingDescriptionCount = 1,
-      .pVertexBindingDescriptions = &bindingDescription,
+      .vertexBindingDescriptionCount =
+          static_cast<uint32_t>(vertexBindingDescriptions.size()),
       .vertexAttributeDescriptionCount =
-          static_cast<uint32_t>(attributeDescriptions.size()),
-      .pVertexAttributeDescriptions = attributeDescriptions.data()};
+          static_cast<uint32_t>(vertexAttributeDescriptions.size())};
 }
 
 void GraphicsPipelineBuilder::addInputAssemblyState() {
@@ -181,13 +337,32 @@ void GraphicsPipelineBuilder::addDynamicState() {
 
 PipelineLayout::PipelineLayout(std::shared_ptr<Device> device,
                                std::shared_ptr<DescriptorSetLayout> setLayout)
-    : device(device), layout(layout) {
+    : PipelineLayout(device, {setLayout}, {}) {}
+
+PipelineLayout::PipelineLayout(
+    std::shared_ptr<Device> device,
+    const std::vector<std::shared_ptr<DescriptorSetLayout>> &setLayouts,
+    const std::vector<VkPushConstantRange> &pushConstantRanges)
+    : device(device), setLayouts(setLayouts) {
+  // Pipelines bind either descriptor buffers or descriptor sets, never both
+  descriptorBuffer = !setLayouts.empty();
+  std::vector<VkDescriptorSetLayout> setLayoutHandles;
+  for (auto &setLayout : setLayouts) {
+    if (setLayout->isDescriptorBuffer() !=
+        setLayouts[0]->isDescriptorBuffer()) {
+      throw std::invalid_argument(
+          "descriptor set layouts mix descriptor buffers and sets!");
+    }
+    descriptorBuffer = descriptorBuffer && setLayout->isDescriptorBuffer();
+    setLayoutHandles.push_back(setLayout->handle());
+  }
+
   VkPipelineLayoutCreateInfo pipelineLayoutInfo = {
       .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-      .setLayoutCount = 1,
-      .pSetLayouts = &setLayout->handle(),
-      .pushConstantRangeCount = 0,
-      .pPushConstantRanges = nullptr};
+      .setLayoutCount = (uint32_t)setLayoutHandles.size(),
+      .pSetLayouts = setLayoutHandles.data(),
+      .pushConstantRangeCount = (uint32_t)pushConstantRanges.size(),
+      .pPushConstantRanges = pushConstantRanges.data()};
 
   VK_THROW_NOT_OK(vkCreatePipelineLayout(device->handle(), &pipelineLayoutInfo,
                                          nullptr, &layout));
@@ -198,18 +373,55 @@ void GraphicsPipelineBuilder::addDescritorSetLayoutBinding(
   descriptorSetLayoutBindings.push_back(binding);
 }
 
+void GraphicsPipelineBuilder::addDescriptorSetLayout(
+    std::shared_ptr<DescriptorSetLayout> layout) {
+  extraSetLayouts.push_back(layout);
+}
+
+void GraphicsPipelineBuilder::addPushConstantRange(VkPushConstantRange range) {
+  pushConstantRanges.push_back(range);
+}
+
 VkPipelineLayout PipelineLayout::handle() { return layout; }
 
+bool PipelineLayout::isDescriptorBuffer() { return descriptorBuffer; }
+
 PipelineLayout::~PipelineLayout() {
   vkDestroyPipelineLayout(device->handle(), layout, nullptr);
 }
 
 DescriptorSetLayout::DescriptorSetLayout(
     std::shared_ptr<Device> device,
-    const std::vector<VkDescriptorSetLayoutBinding> &bindings)
-    : device(device) {
+    const std::vector<VkDescriptorSetLayoutBinding> &bindings,
+    VkDescriptorSetLayoutCreateFlags flags,
+    const std::vector<VkDescriptorBindingFlags> &bindingFlags)
+    : device(device), bindings(bindings), flags(flags) {
+  // Every layout of a descriptor buffer pipeline has to be a descriptor
+  // buffer layout, which update-after-bind layouts can't be and push
+  // descriptor layouts only with descriptorBufferPushDescriptors
+  if (device->getDescriptorBackend() == DescriptorBackend::Buffer) {
+    if (flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT) {
+      throw std::runtime_error(
+          "update-after-bind layouts require the descriptor set backend!");
+    }
+    if ((flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR) &&
+        !device->hasDescriptorBufferPushDescriptors()) {
+      throw std::runtime_error(
+          "push descriptors are not supported with descriptor buffers!");
+    }
+    this->flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+  }
+
+  VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{
+      .sType =
+          VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+      .bindingCount = (uint32_t)bindingFlags.size(),
+      .pBindingFlags = bindingFlags.data()};
+
   VkDescriptorSetLayoutCreateInfo layoutInfo{};
   layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.pNext = bindingFlags.empty() ? nullptr : &bindingFlagsInfo;
+  layoutInfo.flags = this->flags;
   layoutInfo.bindingCount = bindings.size();
   layoutInfo.pBindings = bindings.data();
 
@@ -221,12 +433,184 @@ DescriptorSetLayout::DescriptorSetLayout(
 
 const VkDescriptorSetLayout &DescriptorSetLayout::handle() { return layout; }
 
+const std::vector<VkDescriptorSetLayoutBinding> &
+DescriptorSetLayout::getBindings() {
+  return bindings;
+}
+
+bool DescriptorSetLayout::isPushDescriptor() {
+  return flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+}
+
+bool DescriptorSetLayout::isDescriptorBuffer() {
+  return flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+}
+
 DescriptorSetLayout::~DescriptorSetLayout() {
   vkDestroyDescriptorSetLayout(device->handle(), layout, nullptr);
 }
 
+void GraphicsPipelineBuilder::usePushDescriptors() {
+  if (!device->isExtensionEnabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)) {
+    throw std::runtime_error("push descriptors are not supported!");
+  }
+  descriptorSetLayoutFlags |=
+      VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+}
+
+void GraphicsPipelineBuilder::usePipelineLibraryCache(
+    std::shared_ptr<PipelineLibraryCache> cache) {
+  libraryCache = cache;
+}
+
+PipelineLibraryKey GraphicsPipelineBuilder::getVertexInputKey() {
+  // Layouts known at compile time come with their hash, the descriptions are
+  // still compared
+  PipelineLibraryKey key;
+  key.hash = vertexLayoutHash;
+  auto add = [&](auto value) {
+    if (vertexLayoutHash != 0) {
+      key.store(value);
+    } else {
+      key.add(value);
+    }
+  };
+  for (auto &b : vertexBindingDescriptions) {
+    add(b.binding);
+    add(b.stride);
+    add(b.inputRate);
+  }
+  for (auto &a : vertexAttributeDescriptions) {
+    add(a.location);
+    add(a.binding);
+    add(a.format);
+    add(a.offset);
+  }
+  key.add(inputAssemblyStateInfo.topology);
+  key.add(inputAssemblyStateInfo.primitiveRestartEnable);
+  return key;
+}
+
+PipelineLibraryKey GraphicsPipelineBuilder::getPreRasterizationKey() {
+  auto key = getDescriptorSetLayoutKey();
+  key.add(vertShader->handle());
+  key.add(renderPass->handle());
+  key.add(viewport.x);
+  key.add(viewport.y);
+  key.add(viewport.width);
+  key.add(viewport.height);
+  key.add(viewport.minDepth);
+  key.add(viewport.maxDepth);
+  key.add(scissor.offset.x);
+  key.add(scissor.offset.y);
+  key.add(scissor.extent.width);
+  key.add(scissor.extent.height);
+  key.add(rasterizerStateInfo.depthClampEnable);
+  key.add(rasterizerStateInfo.rasterizerDiscardEnable);
+  key.add(rasterizerStateInfo.polygonMode);
+  key.add(rasterizerStateInfo.cullMode);
+  key.add(rasterizerStateInfo.frontFace);
+  key.add(rasterizerStateInfo.depthBiasEnable);
+  key.add(rasterizerStateInfo.depthBiasConstantFactor);
+  key.add(rasterizerStateInfo.depthBiasClamp);
+  key.add(rasterizerStateInfo.depthBiasSlopeFactor);
+  key.add(rasterizerStateInfo.lineWidth);
+  return key;
+}
+
+PipelineLibraryKey GraphicsPipelineBuilder::getFragmentShaderKey() {
+  auto key = getDescriptorSetLayoutKey();
+  key.add(fragShader->handle());
+  key.add(renderPass->handle());
+  key.add(miltisamplingStateInfo.rasterizationSamples);
+  key.add(miltisamplingStateInfo.sampleShadingEnable);
+  key.add(miltisamplingStateInfo.minSampleShading);
+  return key;
+}
+
+PipelineLibraryKey GraphicsPipelineBuilder::getFragmentOutputKey() {
+  PipelineLibraryKey key;
+  key.add(renderPass->handle());
+  key.add(miltisamplingStateInfo.rasterizationSamples);
+  key.add(miltisamplingStateInfo.alphaToCoverageEnable);
+  key.add(miltisamplingStateInfo.alphaToOneEnable);
+  key.add(colorBlendingStateInfo.logicOpEnable);
+  key.add(colorBlendingStateInfo.logicOp);
+  key.add(colorBlendAttachment.blendEnable);
+  key.add(colorBlendAttachment.srcColorBlendFactor);
+  key.add(colorBlendAttachment.dstColorBlendFactor);
+  key.add(colorBlendAttachment.colorBlendOp);
+  key.add(colorBlendAttachment.srcAlphaBlendFactor);
+  key.add(colorBlendAttachment.dstAlphaBlendFactor);
+  key.add(colorBlendAttachment.alphaBlendOp);
+  key.add(colorBlendAttachment.colorWriteMask);
+  for (float c : colorBlendingStateInfo.blendConstants) {
+    key.add(c);
+  }
+  return key;
+}
+
+PipelineLibraryKey GraphicsPipelineBuilder::getDescriptorSetLayoutKey() {
+  PipelineLibraryKey key;
+  key.add(descriptorSetLayoutFlags);
+  for (auto &b : descriptorSetLayoutBindings) {
+    key.add(b.binding);
+    key.add(b.descriptorType);
+    key.add(b.descriptorCount);
+    key.add(b.stageFlags);
+    key.add(b.pImmutableSamplers);
+  }
+  for (auto &layout : extraSetLayouts) {
+    key.add(layout->handle());
+  }
+  for (auto &range : pushConstantRanges) {
+    key.add(range.stageFlags);
+    key.add(range.offset);
+    key.add(range.size);
+  }
+  return key;
+}
+
 std::shared_ptr<GraphicsPipeline> GraphicsPipelineBuilder::build() {
   return std::make_shared<GraphicsPipeline>(*this);
 }
 
+ComputePipelineBuilder::ComputePipelineBuilder(std::shared_ptr<Device> device)
+    : device(device) {}
+
+void ComputePipelineBuilder::addComputeShader(std::shared_ptr<Shader> shader) {
+  this->shader = shader;
+  shaderStageInfo = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+      .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+      .module = shader->handle(),
+      .pName = "main"};
+}
+
+void ComputePipelineBuilder::addDescritorSetLayoutBinding(
+    VkDescriptorSetLayoutBinding binding) {
+  descriptorSetLayoutBindings.push_back(binding);
+}
+
+void ComputePipelineBuilder::addDescriptorSetLayout(
+    std::shared_ptr<DescriptorSetLayout> layout) {
+  extraSetLayouts.push_back(layout);
+}
+
+void ComputePipelineBuilder::addPushConstantRange(VkPushConstantRange range) {
+  pushConstantRanges.push_back(range);
+}
+
+void ComputePipelineBuilder::usePushDescriptors() {
+  if (!device->isExtensionEnabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME)) {
+    throw std::runtime_error("push descriptors are not supported!");
+  }
+  descriptorSetLayoutFlags |=
+      VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+}
+
+std::shared_ptr<ComputePipeline> ComputePipelineBuilder::build() {
+  return std::make_shared<ComputePipeline>(*this);
+}
+
 } // namespace toffoo::vk
\ No newline at end of file
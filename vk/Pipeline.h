@@ -1,5 +1,8 @@
 #pragma once
+#include "PipelineLibrary.h"
+#include "VertexLayout.h"
 #include <memory>
+#include <span>
 #include <vector>
 #include <vulkan/vulkan.h>
 
@@ -8,13 +11,13 @@ class Shader;
 class SwapChain;
 class Device;
 class GraphicsPipelineBuilder;
+class ComputePipelineBuilder;
 class RenderPass;
 class PipelineLayout;
 class DescriptorSetLayout;
 
-class GraphicsPipeline {
-
-private:
+class Pipeline {
+protected:
   VkPipeline pipeline;
 
   std::shared_ptr<Device> device;
@@ -23,18 +26,42 @@ private:
 
   std::shared_ptr<DescriptorSetLayout> descriptorSetLayout;
 
-  std::shared_ptr<RenderPass> renderPass;
+  Pipeline(std::shared_ptr<Device> device);
 
-public:
-  GraphicsPipeline(GraphicsPipelineBuilder &builder);
+  VkPipelineCreateFlags getCreateFlags();
 
+public:
   VkPipeline handle();
 
   std::shared_ptr<PipelineLayout> getLayout();
 
   std::shared_ptr<DescriptorSetLayout> getDescriptorSetLayout();
 
-  ~GraphicsPipeline();
+  virtual VkPipelineBindPoint getBindPoint() = 0;
+
+  virtual ~Pipeline();
+};
+
+class GraphicsPipeline : public Pipeline {
+private:
+  std::shared_ptr<RenderPass> renderPass;
+
+  void linkLibraries(GraphicsPipelineBuilder &builder);
+
+public:
+  GraphicsPipeline(GraphicsPipelineBuilder &builder);
+
+  VkPipelineBindPoint getBindPoint() override;
+};
+
+class ComputePipeline : public Pipeline {
+private:
+  std::shared_ptr<Shader> shader;
+
+public:
+  ComputePipeline(ComputePipelineBuilder &builder);
+
+  VkPipelineBindPoint getBindPoint() override;
 };
 
 class DescriptorSetLayout {
@@ -42,13 +69,24 @@ private:
   std::shared_ptr<Device> device;
   VkDescriptorSetLayout layout;
 
+  std::vector<VkDescriptorSetLayoutBinding> bindings;
+  VkDescriptorSetLayoutCreateFlags flags;
+
 public:
   DescriptorSetLayout(
       std::shared_ptr<Device> device,
-      const std::vector<VkDescriptorSetLayoutBinding> &bindings);
+      const std::vector<VkDescriptorSetLayoutBinding> &bindings,
+      VkDescriptorSetLayoutCreateFlags flags = 0,
+      const std::vector<VkDescriptorBindingFlags> &bindingFlags = {});
 
   const VkDescriptorSetLayout &handle();
 
+  const std::vector<VkDescriptorSetLayoutBinding> &getBindings();
+
+  bool isPushDescriptor();
+
+  bool isDescriptorBuffer();
+
   ~DescriptorSetLayout();
 };
 
@@ -57,12 +95,23 @@ private:
   std::shared_ptr<Device> device;
   VkPipelineLayout layout;
 
+  std::vector<std::shared_ptr<DescriptorSetLayout>> setLayouts;
+  bool descriptorBuffer;
+
 public:
   PipelineLayout(std::shared_ptr<Device> device,
                  std::shared_ptr<DescriptorSetLayout> setLayout);
 
+  PipelineLayout(
+      std::shared_ptr<Device> device,
+      const std::vector<std::shared_ptr<DescriptorSetLayout>> &setLayouts,
+      const std::vector<VkPushConstantRange> &pushConstantRanges);
+
   VkPipelineLayout handle();
 
+  // All set layouts are descriptor buffer layouts
+  bool isDescriptorBuffer();
+
   ~PipelineLayout();
 };
 
@@ -73,6 +122,10 @@ private:
 
   VkPipelineShaderStageCreateInfo vertShaderStageInfo;
   VkPipelineShaderStageCreateInfo fragShaderStageInfo;
+
+  std::vector<VkVertexInputBindingDescription> vertexBindingDescriptions;
+  std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions;
+  size_t vertexLayoutHash = 0;
   VkPipelineVertexInputStateCreateInfo vertexInputStateInfo;
   VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateInfo;
 
@@ -92,6 +145,23 @@ private:
   std::shared_ptr<Shader> fragShader;
 
   std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings;
+  std::vector<std::shared_ptr<DescriptorSetLayout>> extraSetLayouts;
+  std::vector<VkPushConstantRange> pushConstantRanges;
+
+  VkDescriptorSetLayoutCreateFlags descriptorSetLayoutFlags = 0;
+
+  std::shared_ptr<PipelineLibraryCache> libraryCache;
+
+  void setVertexInputState(
+      std::span<const VkVertexInputAttributeDescription> attributeDescriptions,
+      std::span<const VkVertexInputBindingDescription> bindingDescriptions,
+      size_t layoutHash);
+
+  PipelineLibraryKey getVertexInputKey();
+  PipelineLibraryKey getPreRasterizationKey();
+  PipelineLibraryKey getFragmentShaderKey();
+  PipelineLibraryKey getFragmentOutputKey();
+  PipelineLibraryKey getDescriptorSetLayoutKey();
 
 public:
   GraphicsPipelineBuilder(std::shared_ptr<Device> device,
@@ -100,9 +170,39 @@ public:
   void addVertexShader(std::shared_ptr<Shader> shader);
   void addFragmentShader(std::shared_ptr<Shader> shader);
   void addVertexInputState(
-      const std::vector<VkVertexInputAttributeDescription>
-          &attributeDescriptions,
+      std::span<const VkVertexInputAttributeDescription> attributeDescriptions,
       const VkVertexInputBindingDescription &bindingDescription);
+  // Several bindings, e.g. per vertex and per instance streams
+  void addVertexInputState(
+      std::span<const VkVertexInputAttributeDescription> attributeDescriptions,
+      std::span<const VkVertexInputBindingDescription> bindingDescriptions);
+  // Descriptions and their hash both come from the VertexLayouts, so the
+  // library cache never has to hash them:
+  //
+  //   builder.addVertexInputState(
+  //       VertexLayoutBinding<QuadLayout>{},
+  //       VertexLayoutBinding<InstanceLayout>{
+  //           .binding = 1, .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE,
+  //           .firstLocation = 3});
+  template <typename... Layouts>
+  void addVertexInputState(const VertexLayoutBinding<Layouts> &...layouts) {
+    std::vector<VkVertexInputAttributeDescription> attributes;
+    std::vector<VkVertexInputBindingDescription> bindings;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    (
+        [&] {
+          for (const auto &attribute : Layouts::getAttributeDescriptions(
+                   layouts.binding, layouts.firstLocation)) {
+            attributes.push_back(attribute);
+          }
+          bindings.push_back(Layouts::getBindingDescription(
+              layouts.binding, layouts.inputRate));
+          hash = Layouts::getHash(layouts.binding, layouts.inputRate,
+                                  layouts.firstLocation, hash);
+        }(),
+        ...);
+    setVertexInputState(attributes, bindings, hash);
+  }
   void addInputAssemblyState();
   void addViewportState(std::shared_ptr<SwapChain> swapchain, float width,
                         float height);
@@ -116,8 +216,54 @@ public:
 
   void addDescritorSetLayoutBinding(VkDescriptorSetLayoutBinding binding);
 
+  // Set 0 is built from the added bindings, extra layouts follow as set 1..N
+  void addDescriptorSetLayout(std::shared_ptr<DescriptorSetLayout> layout);
+
+  void addPushConstantRange(VkPushConstantRange range);
+
+  // Make set 0 a push descriptor set written with
+  // CommandBuffers::pushDescriptors instead of allocated from a pool. Throws
+  // without VK_KHR_push_descriptor.
+  void usePushDescriptors();
+
+  // Compile the pipeline from cached VK_EXT_graphics_pipeline_library parts
+  // when the device supports it
+  void usePipelineLibraryCache(std::shared_ptr<PipelineLibraryCache> cache);
+
   std::shared_ptr<GraphicsPipeline> build();
 
   friend class GraphicsPipeline;
 };
+
+class ComputePipelineBuilder {
+private:
+  std::shared_ptr<Device> device;
+
+  VkPipelineShaderStageCreateInfo shaderStageInfo;
+
+  std::shared_ptr<Shader> shader;
+
+  std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings;
+  std::vector<std::shared_ptr<DescriptorSetLayout>> extraSetLayouts;
+  std::vector<VkPushConstantRange> pushConstantRanges;
+
+  VkDescriptorSetLayoutCreateFlags descriptorSetLayoutFlags = 0;
+
+public:
+  ComputePipelineBuilder(std::shared_ptr<Device> device);
+
+  void addComputeShader(std::shared_ptr<Shader> shader);
+
+  void addDescritorSetLayoutBinding(VkDescriptorSetLayoutBinding binding);
+
+  void addDescriptorSetLayout(std::shared_ptr<DescriptorSetLayout> layout);
+
+  void addPushConstantRange(VkPushConstantRange range);
+
+  void usePushDescriptors();
+
+  std::shared_ptr<ComputePipeline> build();
+
+  friend class ComputePipeline;
+};
 } // namespace toffoo::vk
\ No newline at end of file
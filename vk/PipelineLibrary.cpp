@@ -0,0 +1,49 @@
+#include "PipelineLibrary.h"
+#include "Device.h"
+
+namespace toffoo::vk {
+PipelineLibraryCache::PipelineLibraryCache(std::shared_ptr<Device> device)
+    : device(device) {}
+
+VkPipeline
+PipelineLibraryCache::getOrCreate(PipelineLibraryKey key,
+                                  VkGraphicsPipelineLibraryFlagsEXT part,
+                                  VkGraphicsPipelineCreateInfo info,
+                                  const Dependencies &dependencies) {
+  key.add(part);
+
+  auto it = libraries.find(key);
+  if (it != libraries.end()) {
+    return it->second.pipeline;
+  }
+
+  VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{
+      .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+      .flags = part};
+
+  info.pNext = &libraryInfo;
+  info.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+  info.basePipelineHandle = VK_NULL_HANDLE;
+  info.basePipelineIndex = -1;
+
+  VkPipeline library;
+  VK_THROW_NOT_OK(vkCreateGraphicsPipelines(device->handle(), VK_NULL_HANDLE, 1,
+                                            &info, nullptr, &library));
+
+  libraries.emplace(std::move(key), Library{library, dependencies});
+  return library;
+}
+
+size_t PipelineLibraryCache::size() { return libraries.size(); }
+
+PipelineLibraryCache::~PipelineLibraryCache() {
+  for (auto &[key, library] : libraries) {
+    vkDestroyPipeline(device->handle(), library.pipeline, nullptr);
+  }
+}
+
+std::shared_ptr<PipelineLibraryCache>
+createPipelineLibraryCache(std::shared_ptr<Device> device) {
+  return std::make_shared<PipelineLibraryCache>(device);
+}
+} // namespace toffoo::vk
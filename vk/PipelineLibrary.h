@@ -0,0 +1,80 @@
+#pragma once
+#include "Utils.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class PipelineLayout;
+class RenderPass;
+class Shader;
+
+// State a library part is built from, one word per value. Lookups compare the
+// words, the hash only picks the bucket.
+struct PipelineLibraryKey {
+  size_t hash = 0;
+  std::vector<uint64_t> state;
+
+  template <typename T> void add(const T &value) {
+    hashCombine(hash, store(value));
+  }
+
+  // Keeps the value without hashing it, for state covered by a hash that is
+  // known in advance
+  template <typename T> uint64_t store(const T &value) {
+    static_assert(sizeof(T) <= sizeof(uint64_t), "state value too large");
+    uint64_t word = 0;
+    memcpy(&word, &value, sizeof(T));
+    state.push_back(word);
+    return word;
+  }
+
+  bool operator==(const PipelineLibraryKey &other) const {
+    return hash == other.hash && state == other.state;
+  }
+};
+
+// Keeps pre-compiled graphics pipeline library parts so pipelines that share
+// a vertex format, shader or output state only pay for linking
+class PipelineLibraryCache {
+public:
+  struct Dependencies {
+    std::shared_ptr<PipelineLayout> layout;
+    std::vector<std::shared_ptr<Shader>> shaders;
+    std::shared_ptr<RenderPass> renderPass;
+  };
+
+private:
+  struct Library {
+    VkPipeline pipeline;
+    Dependencies dependencies;
+  };
+
+  struct KeyHash {
+    size_t operator()(const PipelineLibraryKey &key) const { return key.hash; }
+  };
+
+  std::unordered_map<PipelineLibraryKey, Library, KeyHash> libraries;
+
+  std::shared_ptr<Device> device;
+
+public:
+  PipelineLibraryCache(std::shared_ptr<Device> device);
+
+  VkPipeline getOrCreate(PipelineLibraryKey key,
+                         VkGraphicsPipelineLibraryFlagsEXT part,
+                         VkGraphicsPipelineCreateInfo info,
+                         const Dependencies &dependencies);
+
+  size_t size();
+
+  ~PipelineLibraryCache();
+};
+
+std::shared_ptr<PipelineLibraryCache>
+createPipelineLibraryCache(std::shared_ptr<Device> device);
+} // namespace toffoo::vk
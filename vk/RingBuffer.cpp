@@ -0,0 +1,57 @@
+#include "RingBuffer.h"
+#include <stdexcept>
+
+namespace toffoo::vk {
+RingBuffer::RingBuffer(std::shared_ptr<Device> device,
+                       VkDeviceSize sizePerFrame, size_t framesInFlight,
+                       VkBufferUsageFlags usage)
+    : Buffer(device, sizePerFrame * framesInFlight, usage,
+             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+      frameSize(sizePerFrame), usage(usage) {
+  map();
+}
+
+void RingBuffer::beginFrame(size_t frameIdx) {
+  frameBegin = frameIdx * frameSize;
+  head = frameBegin;
+}
+
+RingBuffer::Allocation RingBuffer::allocate(VkDeviceSize size,
+                                            VkDeviceSize alignment) {
+  VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+  if (offset + size > frameBegin + frameSize) {
+    throw std::runtime_error("ring buffer frame segment is full!");
+  }
+  head = offset + size;
+  return {offset, static_cast<char *>(mapped) + offset};
+}
+
+VkBufferUsageFlags RingBuffer::getUsage() { return usage; }
+
+WriteDescriptorSetWrapper
+RingBuffer::getWriteDescriptorSet(size_t binding, VkDescriptorType type,
+                                  const Allocation &allocation,
+                                  VkDeviceSize range) {
+  VkDescriptorBufferInfo bufferInfo = {};
+  bufferInfo.buffer = bufferHandle;
+  bufferInfo.offset = allocation.offset;
+  bufferInfo.range = range;
+
+  VkWriteDescriptorSet descriptorWrite = {};
+  descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  descriptorWrite.dstBinding = binding;
+  descriptorWrite.dstArrayElement = 0;
+  descriptorWrite.descriptorCount = 1;
+  descriptorWrite.descriptorType = type;
+  return {descriptorWrite, bufferInfo};
+}
+
+std::shared_ptr<RingBuffer> createRingBuffer(std::shared_ptr<Device> device,
+                                             VkDeviceSize sizePerFrame,
+                                             size_t framesInFlight,
+                                             VkBufferUsageFlags usage) {
+  return std::make_shared<RingBuffer>(device, sizePerFrame, framesInFlight,
+                                      usage);
+}
+} // namespace toffoo::vk
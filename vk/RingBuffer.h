@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Buffer.h"
+#include "WriteDescriptorSetWrapper.h"
+#include <memory>
+
+namespace toffoo::vk {
+class Device;
+
+// Persistently mapped buffer split into one segment per frame in flight.
+// Allocations are bumped linearly and released together by beginFrame.
+class RingBuffer : public Buffer {
+private:
+  VkDeviceSize frameSize;
+  VkDeviceSize frameBegin = 0;
+  VkDeviceSize head = 0;
+
+  VkBufferUsageFlags usage;
+
+public:
+  struct Allocation {
+    VkDeviceSize offset;
+    void *data;
+  };
+
+  RingBuffer(std::shared_ptr<Device> device, VkDeviceSize sizePerFrame,
+             size_t framesInFlight, VkBufferUsageFlags usage);
+
+  // The caller guarantees the GPU is done with the segment of this frame index
+  void beginFrame(size_t frameIdx);
+
+  Allocation allocate(VkDeviceSize size, VkDeviceSize alignment = 1);
+
+  VkBufferUsageFlags getUsage();
+
+  WriteDescriptorSetWrapper getWriteDescriptorSet(size_t binding,
+                                                  VkDescriptorType type,
+                                                  const Allocation &allocation,
+                                                  VkDeviceSize range);
+};
+
+std::shared_ptr<RingBuffer> createRingBuffer(std::shared_ptr<Device> device,
+                                             VkDeviceSize sizePerFrame,
+                                             size_t framesInFlight,
+                                             VkBufferUsageFlags usage);
+} // namespace toffoo::vk
@@ -0,0 +1,74 @@
+#include "SamplerCache.h"
+#include "Utils.h"
+#include <algorithm>
+
+namespace toffoo::vk {
+size_t SamplerDescHash::operator()(const SamplerDesc &desc) const {
+  size_t seed = 0;
+  hashCombine(seed, desc.magFilter);
+  hashCombine(seed, desc.minFilter);
+  hashCombine(seed, desc.mipmapMode);
+  hashCombine(seed, desc.addressModeU);
+  hashCombine(seed, desc.addressModeV);
+  hashCombine(seed, desc.addressModeW);
+  hashCombine(seed, desc.mipLodBias);
+  hashCombine(seed, desc.anisotropyEnable);
+  hashCombine(seed, desc.maxAnisotropy);
+  hashCombine(seed, desc.compareEnable);
+  hashCombine(seed, desc.compareOp);
+  hashCombine(seed, desc.minLod);
+  hashCombine(seed, desc.maxLod);
+  hashCombine(seed, desc.borderColor);
+  hashCombine(seed, desc.unnormalizedCoordinates);
+  return seed;
+}
+
+SamplerCache::SamplerCache(VkDevice device,
+                           const VkPhysicalDeviceLimits &limits)
+    : device(device), maxSamplerAnisotropy(limits.maxSamplerAnisotropy) {}
+
+const VkSampler &SamplerCache::get(const SamplerDesc &desc) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto it = samplers.find(desc);
+  if (it != samplers.end()) {
+    return it->second;
+  }
+
+  VkSamplerCreateInfo samplerInfo{
+      .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+      .magFilter = desc.magFilter,
+      .minFilter = desc.minFilter,
+      .mipmapMode = desc.mipmapMode,
+      .addressModeU = desc.addressModeU,
+      .addressModeV = desc.addressModeV,
+      .addressModeW = desc.addressModeW,
+      .mipLodBias = desc.mipLodBias,
+      .anisotropyEnable = desc.anisotropyEnable,
+      .maxAnisotropy = std::min(desc.maxAnisotropy, maxSamplerAnisotropy),
+      .compareEnable = desc.compareEnable,
+      .compareOp = desc.compareOp,
+      .minLod = desc.minLod,
+      .maxLod = desc.maxLod,
+      .borderColor = desc.borderColor,
+      .unnormalizedCoordinates = desc.unnormalizedCoordinates};
+
+  VkSampler sampler;
+  if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create texture sampler!");
+  }
+
+  return samplers.emplace(desc, sampler).first->second;
+}
+
+size_t SamplerCache::size() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return samplers.size();
+}
+
+SamplerCache::~SamplerCache() {
+  for (auto &[desc, sampler] : samplers) {
+    vkDestroySampler(device, sampler, nullptr);
+  }
+}
+} // namespace toffoo::vk
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+struct SamplerDesc {
+  VkFilter magFilter = VK_FILTER_LINEAR;
+  VkFilter minFilter = VK_FILTER_LINEAR;
+  VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  VkSamplerAddressMode addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  VkSamplerAddressMode addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  VkSamplerAddressMode addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  float mipLodBias = 0.0f;
+  VkBool32 anisotropyEnable = VK_TRUE;
+  // Clamped to maxSamplerAnisotropy of the device
+  float maxAnisotropy = std::numeric_limits<float>::max();
+  VkBool32 compareEnable = VK_FALSE;
+  VkCompareOp compareOp = VK_COMPARE_OP_ALWAYS;
+  float minLod = 0.0f;
+  float maxLod = VK_LOD_CLAMP_NONE;
+  VkBorderColor borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+  VkBool32 unnormalizedCoordinates = VK_FALSE;
+
+  bool operator==(const SamplerDesc &other) const = default;
+};
+
+struct SamplerDescHash {
+  size_t operator()(const SamplerDesc &desc) const;
+};
+
+// Samplers are a limited resource (maxSamplerAllocationCount), so identical
+// descriptions share one VkSampler for the lifetime of the device
+class SamplerCache {
+private:
+  VkDevice device;
+  float maxSamplerAnisotropy;
+
+  std::mutex mutex;
+  std::unordered_map<SamplerDesc, VkSampler, SamplerDescHash> samplers;
+
+public:
+  SamplerCache(VkDevice device, const VkPhysicalDeviceLimits &limits);
+
+  // The returned reference stays valid until the cache is destroyed, so it can
+  // be used as an immutable sampler in descriptor set layouts
+  const VkSampler &get(const SamplerDesc &desc = {});
+
+  size_t size();
+
+  ~SamplerCache();
+};
+} // namespace toffoo::vk
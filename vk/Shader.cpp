@@ -4,7 +4,7 @@
 #include <fstream>
 namespace toffoo::vk {
 
-Shader::Shader(std::shared_ptr<Device> device, const std::vector<char> &code)
+Shader::Shader(std::shared_ptr<Device> device, std::span<const char> code)
     : device(device) {
   VkShaderModuleCreateInfo createInfo{
       .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
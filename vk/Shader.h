@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <span>
 #include <vector>
 #include <vulkan/vulkan.h>
 
@@ -11,7 +12,8 @@ private:
   VkShaderModule shader;
 
 public:
-  Shader(std::shared_ptr<Device> device, const std::vector<char> &code);
+  // code must be 4 byte aligned SPIR-V, it is not referenced after creation
+  Shader(std::shared_ptr<Device> device, std::span<const char> code);
 
   VkShaderModule handle();
 
@@ -0,0 +1,43 @@
+#include "StorageBuffer.h"
+
+namespace toffoo::vk {
+StorageBuffer::StorageBuffer(std::shared_ptr<Device> device, size_t size,
+                             VkBufferUsageFlags extraUsage)
+    : Buffer(device, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | extraUsage,
+             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {}
+
+VkDescriptorSetLayoutBinding
+StorageBuffer::getDescriptorSetLayoutBinding(int binding,
+                                             VkShaderStageFlags stageFlags) {
+  VkDescriptorSetLayoutBinding layoutBinding{};
+  layoutBinding.binding = binding;
+  layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  layoutBinding.descriptorCount = 1;
+  layoutBinding.stageFlags = stageFlags;
+  layoutBinding.pImmutableSamplers = nullptr;
+  return layoutBinding;
+}
+
+WriteDescriptorSetWrapper StorageBuffer::getWriteDescriptorSet(size_t binding) {
+  VkDescriptorBufferInfo bufferInfo = {};
+  bufferInfo.buffer = bufferHandle;
+  bufferInfo.offset = 0;
+  bufferInfo.range = bufferSize;
+
+  VkWriteDescriptorSet descriptorWrite = {};
+  descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  descriptorWrite.dstBinding = binding;
+  descriptorWrite.dstArrayElement = 0;
+  descriptorWrite.descriptorCount = 1;
+  descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  return {descriptorWrite, bufferInfo};
+}
+
+std::shared_ptr<StorageBuffer>
+createStorageBuffer(std::shared_ptr<Device> device, size_t size,
+                    VkBufferUsageFlags extraUsage) {
+  return std::make_shared<StorageBuffer>(device, size, extraUsage);
+}
+
+} // namespace toffoo::vk
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Buffer.h"
+#include "WriteDescriptorSetWrapper.h"
+#include <memory>
+
+namespace toffoo::vk {
+class Device;
+class StorageBuffer : public Buffer {
+public:
+  StorageBuffer(std::shared_ptr<Device> device, size_t size,
+                VkBufferUsageFlags extraUsage = 0);
+
+  WriteDescriptorSetWrapper getWriteDescriptorSet(size_t binding);
+
+  static VkDescriptorSetLayoutBinding
+  getDescriptorSetLayoutBinding(int binding,
+                                VkShaderStageFlags stageFlags =
+                                    VK_SHADER_STAGE_COMPUTE_BIT);
+};
+
+std::shared_ptr<StorageBuffer>
+createStorageBuffer(std::shared_ptr<Device> device, size_t size,
+                    VkBufferUsageFlags extraUsage = 0);
+} // namespace toffoo::vk
@@ -0,0 +1,244 @@
+#include "TextureAtlas.h"
+#include "Buffer.h"
+#include "CommandBuffers.h"
+#include "Device.h"
+#include "Image.h"
+#include "SamplerCache.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+namespace toffoo::vk {
+static const uint32_t texelSize = 4;
+
+static bool isSupportedFormat(VkFormat format) {
+  switch (format) {
+  case VK_FORMAT_R8G8B8A8_UNORM:
+  case VK_FORMAT_R8G8B8A8_SRGB:
+  case VK_FORMAT_B8G8R8A8_UNORM:
+  case VK_FORMAT_B8G8R8A8_SRGB:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Copies the source into dst surrounded by padding texels that repeat its
+// edges, so linear filtering never picks up a neighbouring texture
+static void copyPadded(char *dst, const AtlasSource &source,
+                       uint32_t padding) {
+  auto src = static_cast<const char *>(source.pixels);
+  uint32_t rowSize = (source.width + 2 * padding) * texelSize;
+
+  for (uint32_t y = 0; y < source.height + 2 * padding; y++) {
+    uint32_t srcY = std::clamp(y, padding, source.height + padding - 1);
+    const char *srcRow = src + (srcY - padding) * source.width * texelSize;
+    char *dstRow = dst + y * rowSize;
+
+    for (uint32_t x = 0; x < padding; x++) {
+      memcpy(dstRow + x * texelSize, srcRow, texelSize);
+      memcpy(dstRow + (padding + source.width + x) * texelSize,
+             srcRow + (source.width - 1) * texelSize, texelSize);
+    }
+    memcpy(dstRow + padding * texelSize, srcRow, source.width * texelSize);
+  }
+}
+
+TextureAtlas::TextureAtlas(std::shared_ptr<Device> device,
+                           std::shared_ptr<CommandPool> commandPool,
+                           VkFormat format, uint32_t layerSize,
+                           uint32_t layerCount, uint32_t padding)
+    : padding(padding), device(device), commandPool(commandPool) {
+  if (!isSupportedFormat(format)) {
+    throw std::runtime_error("texture atlas requires a 32-bit color format!");
+  }
+
+  const auto &limits = device->getProperties().limits;
+  this->layerSize = std::min(layerSize, limits.maxImageDimension2D);
+  // A single layer would get a plain 2D view, shaders expect an array
+  layerCount = std::clamp(layerCount, 2u, limits.maxImageArrayLayers);
+  shelves.resize(layerCount);
+
+  // Gutters only protect the base level, so the atlas has no mip chain
+  SamplerDesc samplerDesc{
+      .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+      .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .maxLod = 0.0f};
+  image = std::make_shared<Image>(
+      device, this->layerSize, this->layerSize, format,
+      VK_IMAGE_TILING_OPTIMAL,
+      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 1, layerCount, 0, samplerDesc);
+
+  auto cb = createCommandBuffers(device, commandPool, 1);
+  cb->begin(0);
+
+  Image::recordLayoutTransition(cb->get(0), image->handle(),
+                                VK_IMAGE_LAYOUT_UNDEFINED,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                                layerCount);
+
+  VkClearColorValue clearColor{};
+  VkImageSubresourceRange range{.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                .levelCount = 1,
+                                .layerCount = layerCount};
+  vkCmdClearColorImage(cb->get(0), image->handle(),
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearColor, 1,
+                       &range);
+
+  Image::recordLayoutTransition(cb->get(0), image->handle(),
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1,
+                                layerCount);
+
+  cb->end(0);
+  cb->submit(0);
+}
+
+TextureAtlas::Placement TextureAtlas::allocate(uint32_t width,
+                                               uint32_t height) {
+  for (uint32_t layer = 0; layer < shelves.size(); layer++) {
+    auto &layerShelves = shelves[layer];
+
+    // Best fit: the shortest existing shelf with enough room left
+    Shelf *best = nullptr;
+    for (auto &shelf : layerShelves) {
+      if (shelf.height >= height && layerSize - shelf.used >= width &&
+          (!best || shelf.height < best->height)) {
+        best = &shelf;
+      }
+    }
+
+    if (!best) {
+      uint32_t top = layerShelves.empty()
+                         ? 0
+                         : layerShelves.back().y + layerShelves.back().height;
+      if (layerSize - top < height) {
+        continue;
+      }
+      layerShelves.push_back({.y = top, .height = height, .used = 0});
+      best = &layerShelves.back();
+    }
+
+    Placement placement{.layer = layer, .x = best->used, .y = best->y};
+    best->used += width;
+    return placement;
+  }
+
+  throw std::runtime_error("texture atlas is full!");
+}
+
+std::vector<AtlasRegion>
+TextureAtlas::add(const std::vector<AtlasSource> &sources) {
+  for (const auto &source : sources) {
+    if (source.width == 0 || source.height == 0 ||
+        source.width + 2 * padding > layerSize ||
+        source.height + 2 * padding > layerSize) {
+      throw std::invalid_argument("texture does not fit into atlas layer!");
+    }
+  }
+  if (sources.empty()) {
+    return {};
+  }
+
+  // Tallest first keeps the shelves tight
+  std::vector<size_t> order(sources.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return sources[a].height > sources[b].height;
+  });
+
+  // The shelves are restored when the batch runs out of space, so a failed
+  // batch takes up no room
+  auto previousShelves = shelves;
+  std::vector<Placement> placements(sources.size());
+  size_t stagingSize = 0;
+  try {
+    for (size_t i : order) {
+      uint32_t width = sources[i].width + 2 * padding;
+      uint32_t height = sources[i].height + 2 * padding;
+      placements[i] = allocate(width, height);
+      stagingSize += (size_t)width * height * texelSize;
+    }
+  } catch (...) {
+    shelves = std::move(previousShelves);
+    throw;
+  }
+
+  auto staging = std::make_shared<Buffer>(
+      device, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+  auto data = static_cast<char *>(staging->map());
+
+  std::vector<VkBufferImageCopy> copies;
+  std::vector<AtlasRegion> regions(sources.size());
+  VkDeviceSize offset = 0;
+  for (size_t i = 0; i < sources.size(); i++) {
+    const auto &source = sources[i];
+    const auto &placement = placements[i];
+    uint32_t width = source.width + 2 * padding;
+    uint32_t height = source.height + 2 * padding;
+
+    copyPadded(data + offset, source, padding);
+
+    copies.push_back(
+        {.bufferOffset = offset,
+         .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                              .baseArrayLayer = placement.layer,
+                              .layerCount = 1},
+         .imageOffset = {(int32_t)placement.x, (int32_t)placement.y, 0},
+         .imageExtent = {width, height, 1}});
+
+    regions[i] = {.uvOffset = {(float)(placement.x + padding) / layerSize,
+                               (float)(placement.y + padding) / layerSize},
+                  .uvScale = {(float)source.width / layerSize,
+                              (float)source.height / layerSize},
+                  .layer = placement.layer};
+
+    offset += (VkDeviceSize)width * height * texelSize;
+  }
+
+  auto cb = createCommandBuffers(device, commandPool, 1);
+  cb->begin(0);
+
+  Image::recordLayoutTransition(cb->get(0), image->handle(),
+                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                                image->getArrayLayers());
+
+  vkCmdCopyBufferToImage(cb->get(0), staging->handle(), image->handle(),
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copies.size(),
+                         copies.data());
+
+  Image::recordLayoutTransition(cb->get(0), image->handle(),
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1,
+                                image->getArrayLayers());
+
+  cb->end(0);
+  cb->submit(0);
+
+  return regions;
+}
+
+AtlasRegion TextureAtlas::add(const void *pixels, uint32_t width,
+                              uint32_t height) {
+  return add({{.pixels = pixels, .width = width, .height = height}}).front();
+}
+
+std::shared_ptr<Image> TextureAtlas::getImage() { return image; }
+
+uint32_t TextureAtlas::getLayerSize() { return layerSize; }
+
+std::shared_ptr<TextureAtlas>
+createTextureAtlas(std::shared_ptr<Device> device,
+                   std::shared_ptr<CommandPool> commandPool, VkFormat format,
+                   uint32_t layerSize, uint32_t layerCount, uint32_t padding) {
+  return std::make_shared<TextureAtlas>(device, commandPool, format, layerSize,
+                                        layerCount, padding);
+}
+} // namespace toffoo::vk
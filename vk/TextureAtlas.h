@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+class Device;
+class CommandPool;
+class Image;
+
+// Where a texture ended up inside the atlas, shaders remap its coordinates
+// with uv * uvScale + uvOffset and sample the array at layer. The layout
+// matches the push constants of atlas.frag
+struct AtlasRegion {
+  float uvOffset[2];
+  float uvScale[2];
+  uint32_t layer;
+};
+
+// Tightly packed texels, 4 bytes each
+struct AtlasSource {
+  const void *pixels;
+  uint32_t width;
+  uint32_t height;
+};
+
+// Packs many small textures of the same format into the layers of one 2D
+// array image, so draws using different textures can share a descriptor
+class TextureAtlas {
+private:
+  struct Shelf {
+    uint32_t y;
+    uint32_t height;
+    uint32_t used;
+  };
+
+  struct Placement {
+    uint32_t layer;
+    uint32_t x;
+    uint32_t y;
+  };
+
+  uint32_t layerSize;
+  uint32_t padding;
+
+  // Shelves of each layer, stacked from the top of the layer downwards
+  std::vector<std::vector<Shelf>> shelves;
+
+  std::shared_ptr<Image> image;
+
+  std::shared_ptr<Device> device;
+  std::shared_ptr<CommandPool> commandPool;
+
+  Placement allocate(uint32_t width, uint32_t height);
+
+public:
+  TextureAtlas(std::shared_ptr<Device> device,
+               std::shared_ptr<CommandPool> commandPool,
+               VkFormat format = VK_FORMAT_R8G8B8A8_SRGB,
+               uint32_t layerSize = 2048, uint32_t layerCount = 4,
+               uint32_t padding = 2);
+
+  // Packs the whole batch tallest first and uploads it with a single copy.
+  // Throws when the batch does not fit, textures added before stay valid and
+  // none of the batch is kept
+  std::vector<AtlasRegion> add(const std::vector<AtlasSource> &sources);
+
+  AtlasRegion add(const void *pixels, uint32_t width, uint32_t height);
+
+  std::shared_ptr<Image> getImage();
+
+  uint32_t getLayerSize();
+};
+
+std::shared_ptr<TextureAtlas>
+createTextureAtlas(std::shared_ptr<Device> device,
+                   std::shared_ptr<CommandPool> commandPool,
+                   VkFormat format = VK_FORMAT_R8G8B8A8_SRGB,
+                   uint32_t layerSize = 2048, uint32_t layerCount = 4,
+                   uint32_t padding = 2);
+} // namespace toffoo::vk
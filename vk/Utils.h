@@ -1,4 +1,5 @@
 #pragma once
+#include <functional>
 #include <stdexcept>
 #include <vulkan/vulkan.h>
 
@@ -22,3 +23,8 @@ inline uint32_t findMemoryType(VkPhysicalDevice physicalDevice,
 
   throw std::runtime_error("failed to find suitable memory type!");
 }
+
+template <typename T> inline void hashCombine(size_t &seed, const T &value) {
+  seed ^= std::hash<T>{}(value) + 0x9e3779b97f4a7c15ull + (seed << 6) +
+          (seed >> 2);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+namespace toffoo::vk {
+// Vertex input format of a field type, types without a specialization do not
+// compile. Matrices take one location per column.
+template <typename T> struct VertexAttributeFormat;
+
+#define VK_VERTEX_ATTRIBUTE_FORMAT(type, vkFormat)                             \
+  template <> struct VertexAttributeFormat<type> {                            \
+    static constexpr VkFormat value = vkFormat;                                \
+    static constexpr uint32_t columns = 1;                                     \
+  };
+
+VK_VERTEX_ATTRIBUTE_FORMAT(float, VK_FORMAT_R32_SFLOAT)
+VK_VERTEX_ATTRIBUTE_FORMAT(glm::vec2, VK_FORMAT_R32G32_SFLOAT)
+VK_VERTEX_ATTRIBUTE_FORMAT(glm::vec3, VK_FORMAT_R32G32B32_SFLOAT)
+VK_VERTEX_ATTRIBUTE_FORMAT(glm::vec4, VK_FORMAT_R32G32B32A32_SFLOAT)
+VK_VERTEX_ATTRIBUTE_FORMAT(int32_t, VK_FORMAT_R32_SINT)
+VK_VERTEX_ATTRIBUTE_FORMAT(glm::ivec2, VK_FORMAT_R32G32_SINT)
+VK_VERTEX_ATTRIBUTE_FORMAT(glm::ivec3, VK_FORMAT_R32G32B32_SINT)
+VK_VERTEX_ATTRIBUTE_FORMAT(glm::ivec4, VK_FORMAT_R32G32B32A32_SINT)
+VK_VERTEX_ATTRIBUTE_FORMAT(uint32_t, VK_FORMAT_R32_UINT)
+VK_VERTEX_ATTRIBUTE_FORMAT(glm::uvec2, VK_FORMAT_R32G32_UINT)
+VK_VERTEX_ATTRIBUTE_FORMAT(glm::uvec3, VK_FORMAT_R32G32B32_UINT)
+VK_VERTEX_ATTRIBUTE_FORMAT(glm::uvec4, VK_FORMAT_R32G32B32A32_UINT)
+
+#undef VK_VERTEX_ATTRIBUTE_FORMAT
+
+template <> struct VertexAttributeFormat<glm::mat4> {
+  static constexpr VkFormat value = VK_FORMAT_R32G32B32A32_SFLOAT;
+  static constexpr uint32_t columns = 4;
+};
+
+template <typename T, size_t Offset> struct VertexAttribute {
+  using Type = T;
+  static constexpr VkFormat format = VertexAttributeFormat<T>::value;
+  static constexpr uint32_t offset = Offset;
+  static constexpr uint32_t columns = VertexAttributeFormat<T>::columns;
+  static constexpr uint32_t columnSize = sizeof(T) / columns;
+};
+
+// Describes member of Struct, e.g. VK_VERTEX_ATTRIBUTE(Vertex, pos)
+#define VK_VERTEX_ATTRIBUTE(Struct, member)                                    \
+  ::toffoo::vk::VertexAttribute<decltype(Struct::member),                      \
+                                offsetof(Struct, member)>
+
+// Vertex input state of Vertex generated at compile time. Attributes get
+// consecutive locations in the order they are listed:
+//
+//   using Layout = VertexLayout<Vertex, VK_VERTEX_ATTRIBUTE(Vertex, pos),
+//                               VK_VERTEX_ATTRIBUTE(Vertex, color)>;
+//   constexpr auto attributes = Layout::getAttributeDescriptions();
+template <typename Vertex, typename... Attributes> class VertexLayout {
+private:
+  static_assert(((Attributes::offset + sizeof(typename Attributes::Type) <=
+                  sizeof(Vertex)) &&
+                 ...),
+                "vertex attribute outside of the vertex");
+
+  template <typename Attribute, size_t N>
+  static constexpr void
+  addAttribute(std::array<VkVertexInputAttributeDescription, N> &descriptions,
+               size_t &next, uint32_t binding, uint32_t firstLocation) {
+    for (uint32_t column = 0; column < Attribute::columns; column++) {
+      descriptions[next] = {.location = firstLocation + (uint32_t)next,
+                            .binding = binding,
+                            .format = Attribute::format,
+                            .offset = Attribute::offset +
+                                      column * Attribute::columnSize};
+      next++;
+    }
+  }
+
+  static constexpr void hashCombine(uint64_t &hash, uint64_t value) {
+    // FNV-1a over the bytes of value
+    for (int i = 0; i < 8; i++) {
+      hash ^= (value >> (i * 8)) & 0xff;
+      hash *= 0x100000001b3ull;
+    }
+  }
+
+public:
+  static constexpr uint32_t attributeCount = (Attributes::columns + ... + 0);
+  static constexpr uint32_t stride = sizeof(Vertex);
+
+  static constexpr VkVertexInputBindingDescription getBindingDescription(
+      uint32_t binding = 0,
+      VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX) {
+    return {.binding = binding, .stride = stride, .inputRate = inputRate};
+  }
+
+  static constexpr std::array<VkVertexInputAttributeDescription,
+                              attributeCount>
+  getAttributeDescriptions(uint32_t binding = 0, uint32_t firstLocation = 0) {
+    std::array<VkVertexInputAttributeDescription, attributeCount>
+        descriptions{};
+    size_t next = 0;
+    (addAttribute<Attributes>(descriptions, next, binding, firstLocation), ...);
+    return descriptions;
+  }
+
+  // Identifies the input state for pipeline caching, see
+  // GraphicsPipelineBuilder::addVertexInputState. Layouts of several bindings
+  // chain by passing the hash of the previous one as seed.
+  static constexpr uint64_t
+  getHash(uint32_t binding = 0,
+          VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+          uint32_t firstLocation = 0, uint64_t seed = 0xcbf29ce484222325ull) {
+    uint64_t hash = seed;
+    hashCombine(hash, binding);
+    hashCombine(hash, stride);
+    hashCombine(hash, inputRate);
+    for (const auto &attribute :
+         getAttributeDescriptions(binding, firstLocation)) {
+      hashCombine(hash, attribute.location);
+      hashCombine(hash, attribute.format);
+      hashCombine(hash, attribute.offset);
+    }
+    return hash;
+  }
+};
+
+// Places a VertexLayout at a binding, see
+// GraphicsPipelineBuilder::addVertexInputState
+template <typename Layout> struct VertexLayoutBinding {
+  uint32_t binding = 0;
+  VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+  uint32_t firstLocation = 0;
+};
+} // namespace toffoo::vk